@@ -9,19 +9,48 @@
 */
 //==[[ Headers / Defines / Types ]]=====================================================================================
 
+// ask the C library for the POSIX interfaces too
+#define _DEFAULT_SOURCE
+
 // standard C headers
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <string.h>
 #include <setjmp.h>
+#include <errno.h>
+
+// POSIX headers
+#if defined(__unix__) || defined(__APPLE__)
+#define XORX_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <termios.h>
+#endif
+#ifdef __linux__
+#define XORX_INOTIFY
+#include <sys/inotify.h>
+#endif
 
 // SDL3 headers
+#ifndef XORX_LIBRARY
 #define SDL_MAIN_USE_CALLBACKS
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
+#else
+#include <SDL3/SDL.h>
+#endif
+
+// library interface + shared memory layout
+#include "xorx.h"
+#include "xorx_shm.h"
 
 // various defines for engine + game
 enum {
@@ -44,6 +73,53 @@ enum {
 	MAP_ROWS = 256, // map height in tiles
 	VIEW_COLS = 32, // view width in tiles
 	VIEW_ROWS = 16, // view height in tiles
+	HUD_ROWS = VIDEO_ROWS - VIEW_ROWS, // rows of the HUD below the view
+	DISPLAY_COLS = 128, // widest view around the screen of the player in tiles (--view)
+	DISPLAY_ROWS = 64 + HUD_ROWS, // tallest view around the screen of the player + HUD in tiles (--view)
+	SCREENS = (MAP_COLS / VIEW_COLS) * (MAP_ROWS / VIEW_ROWS), // number of screens in the world
+	LAYER_CACHE = 32, // static layers of the recent screens kept as textures (a large view shows up to 5 x 5 screens)
+
+	POOL_WORKERS = 64, // maximum number of worker threads
+
+	SPECTATORS = 64, // maximum number of connected spectators
+	SPECTATE_KEYFRAME = TICK_RATE * 5, // ticks between two keyframes
+	SPECTATE_MESSAGE = 3 + VIDEO_ROWS * VIDEO_COLS * 2 + 16, // maximum size of an encoded frame message
+
+	PLAYERS = 2, // maximum number of players in a game
+	ROLLBACK_TICKS = 8, // ticks the local side may run ahead of the confirmed remote input
+	ROLLBACK_RING = 32, // ticks of inputs / snapshots kept around (power of two)
+	COOP_MESSAGE = 5, // size of an input message (tick + buttons)
+
+	REPLAY_MAGIC = 0x4c505258, // "XRPL"
+	REPLAY_VERSION = 4, // bumped on every format change
+	REPLAY_SCALARS = 4 + (PLAYERS + 1) * 8 + 5 * 4 + (SCREENS / 64) * 8, // bytes of the game scalars in a keyframe
+	REPLAY_KEYFRAME = TICK_RATE * 60, // ticks between two keyframes of a replay
+
+	SOAK_SLOWEST = 8, // slowest ticks remembered per soak test run
+
+	STARTUP_PHASES = 16, // startup phases timed at most (--timing)
+
+	PACK_MAGIC = 0x4b415058, // "XPAK"
+	PACK_VERSION = 1, // bumped on every format change
+	PACK_ASSETS = 2 + AUDIO_SOUNDS, // most assets in a pack (tileset, world and the sounds)
+	PACK_ALIGN = 16, // alignment of the asset data in a pack
+
+	RENDER_SCALE = 3, // scale of screenshots and replays rendered to images / videos
+	CAPTURE_QUEUE = TICK_RATE * 2, // screens waiting to be written to disk
+
+	PALETTE_COLORS = 64, // palette entries of each group (tiles, water, lava) of the indexed framebuffer
+	PALETTE_CYCLE = 8, // ticks between two steps of the water / lava palette cycling
+	DEATH_FADE = TICK_RATE, // ticks the play screen takes to fade out after the death
+	UPSCALE_MAX = 8, // largest integer factor the software framebuffer gets upscaled by
+	SCROLL_TIME = VIEW_ROWS * TICK_TIME, // milliseconds the screen takes to scroll to the next one
+
+	MINIMAP_COLS = MAP_COLS / 8, // minimap width in pixels (a pixel covers 8 x 4 cells)
+	MINIMAP_ROWS = MAP_ROWS / 4, // minimap height in pixels
+	MINIMAP_SCREEN_COLS = MINIMAP_COLS / (MAP_COLS / VIEW_COLS), // minimap pixels of a screen horizontally
+	MINIMAP_SCREEN_ROWS = MINIMAP_ROWS / (MAP_ROWS / VIEW_ROWS), // minimap pixels of a screen vertically
+
+	TERMINAL_HOLD = 150, // milliseconds a key read from the terminal counts as held (terminals report no key releases)
+	TERMINAL_OUTPUT = 1 << 16, // bytes written to the terminal at once
 };
 
 #define WINDOW_TITLE "Kingdom of Xorx" // title of the window
@@ -114,6 +190,17 @@ typedef enum btn_t {
 	BUTTON_UP = 16, BUTTON_DOWN = 32, BUTTON_LEFT = 64, BUTTON_RIGHT = 128
 } btn_t;
 
+// define render backends
+typedef enum backend_t {
+	BACKEND_AUTO, // framebuffer on SDL's software renderer, tiles otherwise
+	BACKEND_TILES, // draw every tile as a textured quad
+	BACKEND_FRAMEBUFFER, // compose the screen in system memory and stream it into a single texture
+	BACKEND_INDEXED, // like the framebuffer, but compose palette indices and expand them once per frame
+	BACKEND_SURFACE, // draw the changed tiles into the window surface and only update their rectangles (no SDL renderer)
+	BACKEND_TERMINAL, // draw the changed tiles as colored block characters into the terminal (no window at all)
+	BACKEND_COUNT
+} backend_t;
+
 // define directions (clock-wise)
 typedef enum dir_t {
 	DIR_NONE, DIR_NORTH, DIR_EAST, DIR_SOUTH, DIR_WEST
@@ -136,44 +223,78 @@ typedef struct sound_t {
 	unsigned int length; // length of sound in samples
 } sound_t;
 
+// header of an asset pack, the directory and the asset data follow
+typedef struct pack_header_t {
+	uint32_t magic; // PACK_MAGIC
+	uint32_t version; // PACK_VERSION
+	uint32_t count; // number of assets in the directory
+	uint32_t size; // size of the whole pack in bytes
+} pack_header_t;
+
+// an asset in the pack directory (images are XRGB8888 pixels, sounds 16-bit mono PCM at AUDIO_RATE, all in native byte order)
+typedef struct pack_entry_t {
+	char name[24]; // name of the file the asset was converted from
+	uint32_t offset; // position of the asset data in the pack
+	uint32_t size; // size of the asset data in bytes
+	uint32_t width, height; // size of an image in pixels (0 for sounds)
+} pack_entry_t;
+
+// a timed phase of the startup (--timing)
+typedef struct phase_t {
+	const char *name; // name of the phase
+	bool loader; // the phase ran on the loader thread
+	uint64_t begin, end; // performance counters at the begin and the end of the phase
+} phase_t;
+
 // audio mixer channel
 typedef struct voice_t {
 	sound_t sound; // sound effect to play
 	unsigned int position; // current playback position
 } voice_t;
 
-// all global state lives in this nested structure
-static struct state_t {
-	// core system
-	struct {
-		bool running; // keep the engine running
-		jmp_buf error; // error handling routine
-	} core;
+// previous content of a cell, recorded so a tick can be rolled back
+typedef struct undo_t {
+	vec_t v; // position of the cell
+	cell_t cell; // content before it was written
+} undo_t;
+
+// pluggable transport exchanging the co-op input messages with the remote side
+typedef struct transport_t {
+	bool (*send)(struct transport_t *t, const uint8_t *data, int size); // send all bytes, false if the remote side is gone
+	int (*recv)(struct transport_t *t, uint8_t *data, int size); // receive pending bytes (0 if none), -1 if the remote side is gone
+	void (*close)(struct transport_t *t); // shut the transport down
+	int in, out; // file descriptors of the socket / pipe transport
+} transport_t;
+
+// a single item of a parallel job
+typedef void (*job_t)(void *data, int index);
+
+// range of job items owned by a worker (other workers steal from it when they run dry)
+typedef struct slice_t {
+	_Alignas(64) SDL_AtomicInt next; // next item to take
+	int end; // end of the range
+} slice_t;
+
+// a single game instance, everything the simulation reads or writes lives here
+struct xorx_t {
 	// time system
 	struct {
-		uint64_t tick; // current global engine tick
-		uint64_t last; // last measured SDL time
-		uint64_t accu; // accumulated delta time between frames
+		uint64_t tick; // current instance tick
 	} time;
 	// input system
 	struct {
-		btn_t down; // buttons which are currently down
-		btn_t prev; // buttons which were down last tick
+		btn_t down[PLAYERS]; // buttons of every player which are currently down
+		btn_t prev[PLAYERS]; // buttons of every player which were down last tick
 	} input;
 	// audio system
 	struct {
-		SDL_AudioDeviceID device; // SDL audio device object
-		SDL_AudioStream *stream; // SDL audio stream object
-		voice_t voices[AUDIO_VOICES]; // audio mixer channels
-		sound_t sounds[AUDIO_SOUNDS]; // sound effects
 		uint32_t playing; // bit-mask of sounds to play
 	} audio;
 	// video system
 	struct {
-		SDL_Window *window; // SDL window object
-		SDL_Renderer *renderer; // SDL renderer object
-		SDL_Texture *texture; // tileset atlas texture
 		uint8_t data[VIDEO_ROWS][VIDEO_COLS]; // screen content data
+		uint64_t changed[SCREENS / 64]; // bit-mask of the screens whose static layer changed
+		uint64_t minimap[SCREENS / 64]; // bit-mask of the screens whose static layer changed since the minimap saw them
 	} video;
 	// game system
 	struct game_t {
@@ -181,20 +302,317 @@ static struct state_t {
 		bool dead; // flag if we are dead
 		uint8_t rand; // current game random "seed"
 		uint8_t tick; // 8-bit game tick we use for cells
-		vec_t player; // current player position
+		vec_t player[PLAYERS]; // current player positions (invalid_position if not playing)
 		vec_t view; // current view position
 		int life; // current hitpoints
 		int ammo; // current ammunition / swords
 		int flasks; // current amount of flasks
 		int keys; // current amount of keys
 		int gold; // current amount of gold
+		uint64_t visited[SCREENS / 64]; // bit-mask of the screens the player has been on
 		cell_t cells[MAP_ROWS][MAP_COLS]; // cells of our game world
 	} game;
+	// undo journal of cell writes (co-op rollback only)
+	struct {
+		bool enabled; // record every cell write
+		undo_t *undo; // previous cell contents in order of writing
+		int count; // number of recorded writes
+		int capacity; // number of allocated entries
+	} journal;
+	int players; // number of players in the game
+};
+
+// a part of a replay between two keyframes
+typedef struct segment_t {
+	const char *name; // name of the replay file
+	int players; // number of players in the replay
+	const uint8_t *keyframe; // keyframe the segment starts from (behind its 'K')
+	size_t size; // bytes from the keyframe to the end of the replay
+	const uint8_t *inputs; // input of every player for every tick
+	uint32_t ticks; // number of ticks in the segment
+	uint64_t tick; // tick of the starting keyframe
+	uint64_t hash; // hash of the game state at the next keyframe
+	bool complete; // there is a next keyframe
+	bool ok; // verification result
+	char error[128]; // why the segment couldn't be rendered (SDL errors are per thread)
+} segment_t;
+
+// automatic player for soak tests
+typedef struct bot_t {
+	uint32_t rand; // random state of the bot (the game random numbers stay untouched)
+	bool explore; // walk towards unexplored screens and shoot monsters instead of only mashing buttons
+	btn_t hold; // random buttons held down
+	int ticks; // ticks to keep holding them
+	int roam; // ticks left to roam around randomly instead of exploring
+	vec_t last; // player position seen last tick
+	int stuck; // ticks the player hasn't moved
+	uint64_t visited[MAP_ROWS / VIEW_ROWS][MAP_COLS / VIEW_COLS]; // last tick + 1 the player was on a screen (0 = never)
+} bot_t;
+
+// a single soak test run
+typedef struct soak_t {
+	uint32_t seed; // random seed of the bot
+	uint64_t ticks; // ticks to run
+	uint64_t done; // ticks which were run
+	double seconds; // time spent playing
+	int screens; // number of screens visited
+	const char *error; // first broken invariant (NULL if none)
+	uint64_t diverged; // first tick the replay diverged (UINT64_MAX if never)
+	char replay[64]; // file the replay of a failed run is saved to
+	struct {
+		uint64_t tick; // tick number
+		uint64_t time; // time taken in performance counter units
+	} slowest[SOAK_SLOWEST]; // slowest ticks of the run
+} soak_t;
+
+// image of the whole world being exported
+typedef struct map_t {
+	const struct game_t *game; // game to export
+	uint32_t *pixels; // pixels of the image (XRGB8888)
+} map_t;
+
+// static layer of a screen cached in a texture
+typedef struct layer_t {
+	SDL_Texture *texture; // render target holding the static layer (NULL if not created yet)
+	vec_t screen; // top-left cell of the screen (invalid if unused)
+	uint64_t used; // frame the layer was drawn last, the least recently used one gets replaced
+	uint8_t tiles[VIEW_ROWS][VIEW_COLS]; // tiles drawn into the texture
+} layer_t;
+
+// a tile drawn into the terminal as two character cells
+typedef struct glyph_t {
+	char text[2][4]; // UTF-8 character of the left / right half
+	uint8_t fg[2], bg[2]; // ANSI colors (0-15) of the left / right half
+} glyph_t;
+
+// a screen waiting to be written to disk
+typedef struct capture_t {
+	uint8_t data[VIDEO_ROWS][VIDEO_COLS]; // screen content data
+	char name[64]; // file name of the image
+} capture_t;
+
+// everything besides the cells needed to roll an instance back to the start of a tick
+typedef struct snapshot_t {
+	uint64_t tick; // instance tick
+	btn_t prev[PLAYERS]; // buttons which were down the tick before
+	int journal; // length of the undo journal, later writes get undone
+	_Alignas(struct game_t) uint8_t game[offsetof(struct game_t, cells)]; // game scalars
+} snapshot_t;
+
+// all global engine state lives in this nested structure
+static struct state_t {
+	// core system
+	struct {
+		bool running; // keep the engine running
+		jmp_buf error; // error handling routine
+	} core;
+	// time system
+	struct {
+		uint64_t last; // last measured SDL time
+		uint64_t accu; // accumulated delta time between frames
+	} time;
+	// audio system
+	struct {
+		SDL_AudioDeviceID device; // SDL audio device object
+		SDL_AudioStream *stream; // SDL audio stream object
+		voice_t voices[AUDIO_VOICES]; // audio mixer channels
+		sound_t sounds[AUDIO_SOUNDS]; // sound effects
+	} audio;
+	// video system
+	struct {
+		SDL_Window *window; // SDL window object
+		SDL_Renderer *renderer; // SDL renderer object
+		SDL_Texture *texture; // tileset atlas texture
+		backend_t backend; // render backend in use
+		SDL_Texture *frame; // streaming texture of the (upscaled) software framebuffer
+		int scale; // integer factor the framebuffer is upscaled by (0 if there is no texture yet)
+		uint32_t *upscaled; // upscaled framebuffer (NULL if not upscaled)
+		int top; // first framebuffer row being upscaled
+		int cols, rows; // size of the view around the screen of the player in tiles (--view), the HUD goes below
+		uint8_t shown[DISPLAY_ROWS][DISPLAY_COLS]; // tiles of the view + HUD in this frame
+		uint32_t pixels[DISPLAY_ROWS * TILE_HEIGHT][DISPLAY_COLS * TILE_WIDTH]; // software framebuffer (XRGB8888)
+		uint8_t drawn[DISPLAY_ROWS][DISPLAY_COLS]; // tiles composed in the framebuffer / surface / terminal
+		bool stale; // framebuffer has to be composed completely
+		bool layers; // cache the static layers of the screens (tiles backend with render targets)
+		layer_t cache[LAYER_CACHE]; // static layers of the recent screens
+		uint64_t frames; // number of static layers drawn so far
+		SDL_Surface *strip; // the tileset pixels as a surface with all tiles below each other
+		vec_t size; // size of the window surface drawn last
+		uint8_t indexed[DISPLAY_ROWS * TILE_HEIGHT][DISPLAY_COLS * TILE_WIDTH]; // palette indices of the indexed framebuffer
+		uint32_t lut[2][3 * PALETTE_COLORS]; // palette of the play screen / the HUD in the last frame
+		uint64_t alive; // last tick the player was alive (fades the screen after the death)
+		vec_t view; // view of the game the screen scrolls to
+		vec_t from; // pixel position of the play screen the scrolling started at
+		vec_t position; // pixel position of the play screen in the last frame
+		uint64_t start; // time the scrolling started
+		bool scrolling; // the last frame showed the play screen between two screens
+	} video;
+	// input system
+	struct {
+		btn_t buttons; // buttons held down on this machine
+		bool bot; // let a bot press the buttons
+	} input;
+	// minimap of the visited screens (always on the pause screen, M toggles it on top of the view)
+	struct {
+		uint32_t pixels[MINIMAP_ROWS][MINIMAP_COLS]; // the minimap (XRGB8888)
+		uint8_t indices[MINIMAP_ROWS][MINIMAP_COLS]; // the minimap as palette indices for the indexed framebuffer
+		uint32_t colors[256]; // most used color of every tile
+		uint8_t shades[256]; // most used color of every tile as palette index
+		uint32_t marker; // brightest color of the tileset, it marks the player
+		uint8_t marker_shade; // brightest color as palette index
+		uint64_t visited[SCREENS / 64]; // visited screens drawn into the minimap
+		vec_t position; // minimap pixel the player is marked on
+		vec_t at; // top-left display pixel the minimap was shown at
+		SDL_Texture *texture; // the minimap as texture (tiles backend)
+		bool overlay; // show the minimap on top of the view
+		bool changed; // pixels changed since the last frame
+		bool shown; // the minimap was shown in the last frame
+	} minimap;
+	// terminal renderer (--renderer terminal)
+	struct {
+		glyph_t glyphs[256]; // every tile as colored characters
+		int fg, bg; // colors the terminal draws with right now (-1 if unknown)
+		uint64_t release; // time the keys read from the terminal are let go
+		bool raw; // stdin was switched to raw mode
+#ifdef XORX_POSIX
+		struct termios saved; // terminal settings to restore on exit
+		volatile sig_atomic_t resized; // the terminal was resized, draw everything again
+#endif
+	} terminal;
+	bot_t bot; // automatic player (--bot)
+	// worker pool
+	struct {
+		int count; // number of workers including the calling thread
+		SDL_Thread *threads[POOL_WORKERS]; // background worker threads
+		SDL_Mutex *mutex; // guards the job hand-over
+		SDL_Condition *wake; // signals a new job to the workers
+		SDL_Condition *done; // signals a finished worker to the caller
+		unsigned int generation; // incremented for every job
+		int busy; // number of workers still working on the job
+		bool quit; // shut the workers down
+		job_t job; // current job routine
+		void *data; // current job data
+		slice_t slices[POOL_WORKERS]; // item ranges of every worker
+	} pool;
+	// startup (--timing)
+	struct {
+		bool timing; // log how long the startup phases took once the first frame is shown
+		uint64_t start; // performance counter when the startup began
+		uint64_t shown; // performance counter when the first frame was shown
+		SDL_Thread *loader; // thread loading the assets while the window comes up
+		char error[1024]; // error message of the loader thread
+		SDL_AtomicInt count; // number of finished phases
+		phase_t phases[STARTUP_PHASES]; // the finished phases
+	} startup;
+	// hot reload of the assets (--reload)
+	struct {
+		bool enabled; // watch the assets
+		int fd; // inotify descriptor watching the current directory (-1 if none)
+		uint32_t world[MAP_ROWS][MAP_COLS]; // colors of world.bmp the world was built from
+		bool warned; // a moved player start was reported
+	} reload;
+	// asset pack (--pack)
+	struct {
+		const uint8_t *data; // the whole pack
+		size_t size; // size of the pack in bytes
+		bool mapped; // data is memory-mapped
+		bool loaded; // data was read into memory
+	} pack;
+	// shared memory export
+	struct {
+		const char *name; // name of the shared memory object
+		xorx_shm_t *ring; // mapped ring external tools read from
+	} shm;
+	// spectator broadcast
+	struct {
+		const char *path; // socket path of the broadcast server
+		int server; // listening socket of the broadcast server (-1 if none)
+		int viewer; // connection of the spectator viewer (-1 if none)
+		int clients[SPECTATORS]; // connected spectators
+		int count; // number of connected spectators
+		uint8_t sent[VIDEO_ROWS][VIDEO_COLS]; // screen content sent last tick
+		uint8_t buffer[SPECTATE_MESSAGE * 4]; // received bytes not decoded yet
+		int length; // number of bytes in buffer
+	} spectate;
+	// lockstep co-op
+	struct {
+		const char *path; // socket path while waiting for the second player
+		int server; // listening socket while waiting for the second player (-1 if none)
+		transport_t transport; // connection to the remote side (no send routine if not connected)
+		int local; // player index of this side
+		uint64_t remote; // number of ticks the remote input is known for
+		btn_t last; // last known remote input, also the prediction for the ticks after it
+		uint64_t rollback; // first simulated tick which used a wrong prediction (UINT64_MAX if none)
+		btn_t inputs[ROLLBACK_RING][PLAYERS]; // input of every player for the recent ticks
+		snapshot_t snapshots[ROLLBACK_RING]; // instance before the recent ticks
+		uint8_t buffer[COOP_MESSAGE * 64]; // received bytes not decoded yet
+		int length; // number of bytes in buffer
+	} coop;
+	// replay recording
+	struct {
+		const char *path; // file to record the replay to
+		SDL_IOStream *file; // replay file being written
+		xorx_t *ctx; // instance the keyframes are taken from (the game itself, co-op simulates the final input on its own)
+		uint8_t inputs[REPLAY_KEYFRAME][PLAYERS]; // input of the ticks since the last keyframe
+		int count; // number of ticks in inputs
+	} replay;
+	// replay verification
+	struct {
+		segment_t *segments; // segments of all replays
+		int count; // number of segments
+		int capacity; // number of allocated segments
+	} verify;
+	// replay rendering
+	struct {
+		const char *path; // video file or prefix of the image files
+		bool y4m; // write a Y4M video instead of BMP images
+		uint64_t first; // tick of the first rendered frame
+		size_t header; // size of the Y4M header in front of the first frame
+	} render;
+	// screenshots / frame capture written on a background thread
+	struct {
+		SDL_Thread *thread; // writes the queued screens to disk
+		SDL_Mutex *mutex; // guards the queue and the tileset while a screen gets composed
+		SDL_Condition *wake; // signals a queued screen to the thread
+		bool quit; // shut the thread down once the queue is empty
+		capture_t queue[CAPTURE_QUEUE]; // screens waiting to be written
+		int head; // oldest queued screen
+		int count; // number of queued screens
+		bool recording; // capture the screen of every tick
+		uint64_t frame; // number of the next captured frame
+		uint64_t dropped; // frames dropped because the queue was full
+	} capture;
+	// tileset pixels for the software blitters (read-only once loaded, but see reload_tiles())
+	struct {
+		uint32_t pixels[256][TILE_HEIGHT][TILE_WIDTH]; // every tile as XRGB8888
+		uint8_t indices[256][TILE_HEIGHT][TILE_WIDTH]; // every tile as palette indices (water / lava use their own group)
+		uint32_t palette[PALETTE_COLORS]; // colors of the tileset
+		int colors; // number of colors (0 if there are too many for the indexed framebuffer)
+		uint8_t cycle[2][PALETTE_COLORS]; // water / lava colors by brightness, they take turns
+		uint8_t position[2][PALETTE_COLORS]; // position of every color in its cycle
+		int length[2]; // number of water / lava colors
+		uint8_t background[2]; // most used water / lava color, it never cycles
+	} tileset;
+	// world system (read-only once loaded, shared by all instances)
+	struct {
+		struct game_t game; // pristine world every new game starts from
+	} world;
+	xorx_t xorx; // the game instance driven by the engine
 } state;
 
 // define invalid position vector
 static const vec_t invalid_position = {-1, -1};
 
+// errors on the loader thread jump here, the main thread fails with the message later
+static _Thread_local jmp_buf *loader_error;
+
+// asset pack compiled into the game (make embed generates xorx_pak.h)
+#ifdef XORX_EMBED
+_Alignas(PACK_ALIGN) static const uint8_t embedded_pack[] = {
+#include "xorx_pak.h"
+};
+#endif
+
 
 //==[[ Various Routines ]]==============================================================================================
 
@@ -214,10 +632,10 @@ static int clampi(const int x, const int min, const int max) {
 }
 
 // return random number for gameplay
-static unsigned int rnd(void) {
+static unsigned int rnd(xorx_t *ctx) {
 	// we use a static array of 256 random bytes ... it works for DOOM it works for us :)
 	static const uint8_t data[256] = { 87, 31, 118, 249, 64, 152, 247, 255, 254, 202, 250, 123, 39, 194, 240, 135, 117, 130, 66, 219, 48, 225, 37, 237, 105, 176, 78, 198, 99, 85, 3, 34, 61, 96, 50, 45, 43, 136, 203, 23, 119, 132, 175, 131, 178, 19, 36, 70, 241, 183, 140, 161, 199, 67, 155, 86, 220, 223, 65, 233, 71, 2, 192, 35, 244, 134, 166, 141, 236, 186, 46, 116, 184, 195, 205, 179, 181, 30, 109, 215, 245, 206, 228, 191, 187, 15, 115, 20, 93, 145, 113, 60, 151, 231, 137, 83, 209, 174, 59, 62, 89, 22, 51, 177, 114, 129, 7, 169, 171, 126, 18, 79, 160, 16, 180, 163, 232, 207, 144, 1, 246, 230, 94, 122, 167, 172, 104, 0, 128, 72, 90, 12, 76, 196, 41, 190, 193, 52, 149, 68, 189, 73, 100, 95, 218, 121, 156, 33, 108, 8, 157, 63, 77, 150, 139, 138, 162, 107, 82, 88, 200, 234, 74, 28, 110, 54, 229, 4, 84, 133, 239, 103, 125, 211, 153, 159, 197, 29, 102, 27, 142, 24, 158, 253, 222, 217, 204, 148, 147, 170, 213, 111, 226, 208, 56, 168, 143, 6, 165, 201, 47, 112, 92, 251, 13, 212, 55, 242, 188, 91, 80, 146, 210, 243, 235, 81, 124, 252, 14, 238, 221, 127, 5, 53, 106, 214, 227, 42, 101, 57, 38, 21, 9, 97, 40, 44, 248, 164, 98, 75, 32, 154, 11, 10, 182, 224, 173, 17, 185, 25, 58, 26, 216, 120, 69, 49 };
-	return data[state.game.rand++];
+	return data[ctx->game.rand++];
 }
 
 // shortcut to create 2D vector
@@ -251,57 +669,63 @@ static vec_t vmove(const vec_t v, const dir_t d) {
 	return vadd(v, vdir(d));
 }
 
+// return the manhattan length of a vector
+static int vlen(const vec_t v) {
+	return abs(v.x) + abs(v.y);
+}
+
 // return the base vector for the given vector (normalized to VIEW_COLS/VIEW_ROWS)
 static vec_t vbase(const vec_t v) {
 	return (vec_t){ .x = (v.x / VIEW_COLS) * VIEW_COLS, .y = (v.y / VIEW_ROWS) * VIEW_ROWS };
 }
 
-// check if button is down
-static bool btn(const btn_t mask) {
-	return state.input.down & mask;
+// check if button is down for the given player
+static bool btn(xorx_t *ctx, const int id, const btn_t mask) {
+	return ctx->input.down[id] & mask;
 }
 
-// check if button was just pressed
-static bool btnp(const btn_t mask) {
-	return (state.input.down & (~state.input.prev)) & mask;
+// check if button was just pressed by any player
+static bool btnp(xorx_t *ctx, const btn_t mask) {
+	for (int i = 0; i < PLAYERS; ++i) if ((ctx->input.down[i] & (~ctx->input.prev[i])) & mask) return true;
+	return false;
 }
 
 // clear the whole screen
-static void cls(void) {
-	memset(state.video.data, 0, sizeof(state.video.data));
+static void cls(xorx_t *ctx) {
+	memset(ctx->video.data, 0, sizeof(ctx->video.data));
 }
 
 // draw single tile to screen
-static void draw(const int x, const int y, const uint8_t tile) {
-	if ((x >= 0) && (x < VIDEO_COLS) && (y >= 0) && (y < VIDEO_ROWS)) state.video.data[y][x] = tile;
+static void draw(xorx_t *ctx, const int x, const int y, const uint8_t tile) {
+	if ((x >= 0) && (x < VIDEO_COLS) && (y >= 0) && (y < VIDEO_ROWS)) ctx->video.data[y][x] = tile;
 }
 
 // print text to screen
-static void print(int x, const int y, const char *text) {
-	for (; *text; ++text, ++x) draw(x, y, (uint8_t)*text);
+static void print(xorx_t *ctx, int x, const int y, const char *text) {
+	for (; *text; ++text, ++x) draw(ctx, x, y, (uint8_t)*text);
 }
 
 // play sound effect
-static void sound(const int id) {
-	if ((id >= 0) && (id < AUDIO_SOUNDS)) state.audio.playing |= 1 << id;
+static void sound(xorx_t *ctx, const int id) {
+	if ((id >= 0) && (id < AUDIO_SOUNDS)) ctx->audio.playing |= 1 << id;
 }
 
 // center text on screen
-static void center(const int y, const char *text) {
-	print((VIDEO_COLS - strlen(text)) / 2, y, text);
+static void center(xorx_t *ctx, const int y, const char *text) {
+	print(ctx, (VIDEO_COLS - strlen(text)) / 2, y, text);
 }
 
 // draw a border
-static void border(const int x0, const int y0, const int x1, const int y1) {
-	for (int x = x0 + 1; x < x1; ++x) { draw(x, y0, TILE_BORDER_LR); draw(x, y1, TILE_BORDER_LR); }
-	for (int y = y0 + 1; y < y1; ++y) { draw(x0, y, TILE_BORDER_UD); draw(x1, y, TILE_BORDER_UD); }
-	draw(x0, y0, TILE_BORDER_CORNER); draw(x1, y0, TILE_BORDER_CORNER);
-	draw(x0, y1, TILE_BORDER_CORNER); draw(x1, y1, TILE_BORDER_CORNER);
+static void border(xorx_t *ctx, const int x0, const int y0, const int x1, const int y1) {
+	for (int x = x0 + 1; x < x1; ++x) { draw(ctx, x, y0, TILE_BORDER_LR); draw(ctx, x, y1, TILE_BORDER_LR); }
+	for (int y = y0 + 1; y < y1; ++y) { draw(ctx, x0, y, TILE_BORDER_UD); draw(ctx, x1, y, TILE_BORDER_UD); }
+	draw(ctx, x0, y0, TILE_BORDER_CORNER); draw(ctx, x1, y0, TILE_BORDER_CORNER);
+	draw(ctx, x0, y1, TILE_BORDER_CORNER); draw(ctx, x1, y1, TILE_BORDER_CORNER);
 }
 
 // return formatted string printf-style
 static const char *strf(const char *fmt, ...) {
-	static char buffer[1024]; va_list va;
+	static _Thread_local char buffer[1024]; va_list va;
 	va_start(va, fmt); vsnprintf(buffer, sizeof(buffer), fmt, va); va_end(va);
 	return buffer;
 }
@@ -310,70 +734,130 @@ static const char *strf(const char *fmt, ...) {
 static _Noreturn void fail(const char *fmt, ...) {
 	char message[1024]; va_list va;
 	va_start(va, fmt); vsnprintf(message, sizeof(message), fmt, va); va_end(va);
-	SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error!", message, state.video.window);
+	if (loader_error) {
+		SDL_strlcpy(state.startup.error, message, sizeof(state.startup.error));
+		longjmp(*loader_error, 1);
+	}
+	if (!SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error!", message, state.video.window)) SDL_Log("Error! %s", message);
 	longjmp(state.core.error, 1);
 }
 
+// find an asset in the pack, NULL without a pack or if it isn't in there
+static const pack_entry_t *find_asset(const char *name) {
+	if (!state.pack.data) return NULL;
+	const pack_header_t *header = (const pack_header_t*)state.pack.data;
+	const pack_entry_t *entries = (const pack_entry_t*)(header + 1);
+	for (uint32_t i = 0; i < header->count; ++i) if (!strcmp(entries[i].name, name)) return &entries[i];
+	return NULL;
+}
+
+// load an image, out of the pack the surface just points to the pixels in there
+static SDL_Surface *load_image(const char *name) {
+	if (!state.pack.data) return SDL_LoadBMP(name);
+	const pack_entry_t *asset = find_asset(name);
+	if (!asset || !asset->width) { SDL_SetError("%s isn't in the pack", name); return NULL; }
+	return SDL_CreateSurfaceFrom(asset->width, asset->height, SDL_PIXELFORMAT_XRGB8888, (void*)(state.pack.data + asset->offset), asset->width * sizeof(uint32_t));
+}
+
 // check if vector is inside the world
 static bool inside(const vec_t v) {
 	return (v.x >= 0) && (v.x < MAP_COLS) && (v.y >= 0) && (v.y < MAP_ROWS);
 }
 
 // visible checks if the current vector is visible
-static bool visible(const vec_t v) {
-	return veq(vbase(v), state.game.view);
+static bool visible(xorx_t *ctx, const vec_t v) {
+	return veq(vbase(v), ctx->game.view);
 }
 
 // get a cell from the world
-static cell_t get(const vec_t v) {
-	return inside(v) ? state.game.cells[v.y][v.x] : (cell_t){ .tile = TILE_WALL_0 };
+static cell_t get(xorx_t *ctx, const vec_t v) {
+	return inside(v) ? ctx->game.cells[v.y][v.x] : (cell_t){ .tile = TILE_WALL_0 };
+}
+
+// remember the content of a cell before it gets written
+static void record(xorx_t *ctx, const vec_t v) {
+	if (ctx->journal.count == ctx->journal.capacity) {
+		const int capacity = maxi(1024, ctx->journal.capacity * 2);
+		undo_t *undo = SDL_realloc(ctx->journal.undo, capacity * sizeof(undo_t));
+		if (!undo) fail("Out of memory");
+		ctx->journal.undo = undo;
+		ctx->journal.capacity = capacity;
+	}
+	ctx->journal.undo[ctx->journal.count++] = (undo_t){ .v = v, .cell = ctx->game.cells[v.y][v.x] };
+}
+
+// tile of a cell in the static layer of its screen (things which change on their own show the floor)
+static uint8_t static_tile(const uint8_t tile) {
+	return ((tile >= TILE_WALL_0) && (tile <= TILE_GRASS_1)) || (tile == TILE_WALL_X) ? tile : TILE_EMPTY;
+}
+
+// number of the screen a cell is on
+static int screen_index(const vec_t v) {
+	return (v.y / VIEW_ROWS) * (MAP_COLS / VIEW_COLS) + v.x / VIEW_COLS;
+}
+
+// mark the static layer of the screen as changed if the cell changes it
+static void touch(xorx_t *ctx, const vec_t v, const uint8_t tile) {
+	if (static_tile(ctx->game.cells[v.y][v.x].tile) == static_tile(tile)) return;
+	const int screen = screen_index(v);
+	ctx->video.changed[screen / 64] |= 1ull << (screen % 64);
+	ctx->video.minimap[screen / 64] |= 1ull << (screen % 64);
+}
+
+// remember the screen in the view as visited
+static void visit(xorx_t *ctx) {
+	const int screen = screen_index(ctx->game.view);
+	ctx->game.visited[screen / 64] |= 1ull << (screen % 64);
 }
 
 // put a cell to world
-static void put(const vec_t v, const cell_t c) {
-	if (inside(v)) state.game.cells[v.y][v.x] = c;
+static void put(xorx_t *ctx, const vec_t v, const cell_t c) {
+	if (!inside(v)) return;
+	if (ctx->journal.enabled) record(ctx, v);
+	touch(ctx, v, c.tile);
+	ctx->game.cells[v.y][v.x] = c;
 }
 
 // clear will clear a cell
-static void clear(const vec_t v) {
-	put(v, (cell_t){});
+static void clear(xorx_t *ctx, const vec_t v) {
+	put(ctx, v, (cell_t){});
 }
 
 // shape will shape a cell with tile and given ticks to activate again
-static void shape(const vec_t v, const uint8_t tile, const uint8_t ticks) {
-	put(v, (cell_t){ .tile = tile, .tick = state.game.tick + ticks });
+static void shape(xorx_t *ctx, const vec_t v, const uint8_t tile, const uint8_t ticks) {
+	put(ctx, v, (cell_t){ .tile = tile, .tick = ctx->game.tick + ticks });
 }
 
 // hibernate cell
-static void hibernate(const vec_t v) {
-	const cell_t cell = get(v);
-	put(v, (cell_t){ .tile = cell.tile, .tick = (cell.tick + 256 - state.game.tick) % 256 });
+static void hibernate(xorx_t *ctx, const vec_t v) {
+	const cell_t cell = get(ctx, v);
+	put(ctx, v, (cell_t){ .tile = cell.tile, .tick = (cell.tick + 256 - ctx->game.tick) % 256 });
 }
 
 // explode a cell
-static void explode(const vec_t v) {
-	shape(v, TILE_EXPLOSION_0, 2);
-	sound(SOUND_EXPLODE);
+static void explode(xorx_t *ctx, const vec_t v) {
+	shape(ctx, v, TILE_EXPLOSION_0, 2);
+	sound(ctx, SOUND_EXPLODE);
 }
 
 // return random direction
-static dir_t random_dir(void) {
-	return DIR_NORTH+rnd()%4;
+static dir_t random_dir(xorx_t *ctx) {
+	return DIR_NORTH+rnd(ctx)%4;
 }
 
 // return direction based on player input
-static dir_t input_dir(void) {
-	if (btn(BUTTON_UP)) return DIR_NORTH;
-	if (btn(BUTTON_DOWN)) return DIR_SOUTH;
-	if (btn(BUTTON_LEFT)) return DIR_WEST;
-	if (btn(BUTTON_RIGHT)) return DIR_EAST;
+static dir_t input_dir(xorx_t *ctx, const int id) {
+	if (btn(ctx, id, BUTTON_UP)) return DIR_NORTH;
+	if (btn(ctx, id, BUTTON_DOWN)) return DIR_SOUTH;
+	if (btn(ctx, id, BUTTON_LEFT)) return DIR_WEST;
+	if (btn(ctx, id, BUTTON_RIGHT)) return DIR_EAST;
 	return DIR_NONE;
 }
 
 // return direction to walk from src -> dst
-static dir_t chase_dir(const vec_t src, const vec_t dst) {
+static dir_t chase_dir(xorx_t *ctx, const vec_t src, const vec_t dst) {
 	vec_t delta = vsub(dst, src);
-	if (delta.x && delta.y) { if (rnd()%2) delta.x = 0; else delta.y = 0; }
+	if (delta.x && delta.y) { if (rnd(ctx)%2) delta.x = 0; else delta.y = 0; }
 	if (delta.x < 0) return DIR_WEST;
 	if (delta.x > 0) return DIR_EAST;
 	if (delta.y < 0) return DIR_NORTH;
@@ -385,8 +869,8 @@ static dir_t chase_dir(const vec_t src, const vec_t dst) {
 //==[[ Gameplay Routines ]]=============================================================================================
 
 // returns true if there is a wall
-static bool iswall(const vec_t v) {
-	switch (get(v).tile) {
+static bool iswall(xorx_t *ctx, const vec_t v) {
+	switch (get(ctx, v).tile) {
 		case TILE_WALL_0: case TILE_WALL_1: case TILE_WALL_2: case TILE_WALL_3: case TILE_WALL_X:
 			return true;
 		default:
@@ -395,89 +879,165 @@ static bool iswall(const vec_t v) {
 }
 
 // returns true if tile is completely surrounded by walls
-static bool enclosed(const vec_t src) {
+static bool enclosed(xorx_t *ctx, const vec_t src) {
 	for (int y = -1; y <= 1; ++y) {
 		for (int x = -1; x <= 1; ++x) {
-			if (!iswall(vadd(src, vec2(x, y)))) return false;
+			if (!iswall(ctx, vadd(src, vec2(x, y)))) return false;
 		}
 	}
 	return true;
 }
 
-// start new game will start a completely new game
-static void start_game(void) {
+// build a cell of the world from the color of its pixel in world.bmp
+static void spawn(xorx_t *ctx, const vec_t v, const uint32_t color) {
+	switch (color) {
+		default: /* floor */ clear(ctx, v); break;
+		case 0x4e4a4e: /* walls */ shape(ctx, v, TILE_WALL_0 + rnd(ctx)%4, 0); break;
+		case 0x8595a1: /* boulder */ shape(ctx, v, TILE_BOULDER, 0); break;
+		case 0x70402a: /* ruin */ shape(ctx, v, TILE_RUIN_0 + rnd(ctx)%2, 0); break;
+		case 0x004000: /* tree */ shape(ctx, v, TILE_TREE_0 + rnd(ctx)%2, 0); break;
+		case 0x4a2a1b: /* dead tree */ shape(ctx, v, TILE_TREE_2 + rnd(ctx)%2, 0); break;
+		case 0x008000: /* grass*/ shape(ctx, v, TILE_GRASS_0 + rnd(ctx)%2, 0); break;
+		case 0x000096: /* water */ shape(ctx, v, TILE_WATER_0 + rnd(ctx)%2, 16); break;
+		case 0xffffff: /* player */ shape(ctx, v, TILE_PLAYER_STAND, 1); ctx->game.player[0] = v; break;
+		case 0x400000: /* monster 0 */ shape(ctx, v, TILE_MONSTER_0, 1); break;
+		case 0x800000: /* monster 1 */ shape(ctx, v, TILE_MONSTER_1, 1); break;
+		case 0xc00000: /* monster 2 */ shape(ctx, v, TILE_MONSTER_2, 1); break;
+		case 0xff0000: /* monster 3 */ shape(ctx, v, TILE_MONSTER_3, 1); break;
+		case 0xff8000: /* bolt trap */ shape(ctx, v, TILE_BOLT_TRAP_0, rnd(ctx)%16); break;
+		case 0xff6400: /* shrine */ shape(ctx, v, TILE_SHRINE_0, 30+rnd(ctx)%16); break;
+		case 0x6dc2ca: /* teleport */ shape(ctx, v, TILE_TELEPORT, 0); break;
+	}
+}
+
+// load "world.bmp" and map the colors into the pristine world
+static bool load_world(const char *name) {
 	// setup new game state
-	state.game = (struct game_t){
-		.player = invalid_position,
+	state.world.game = (struct game_t){
 		.life = 10,
 		.ammo = 5,
 	};
-	// load "world.bmp" and map the colors
-	SDL_Surface *surface = SDL_LoadBMP("world.bmp");
-	if (!surface) return;
+	for (int i = 0; i < PLAYERS; ++i) state.world.game.player[i] = invalid_position;
+	SDL_Surface *surface = load_image(name);
+	if (!surface) return false;
 	if ((surface->w != MAP_COLS) || (surface->h != MAP_ROWS)) {
 		SDL_DestroySurface(surface);
 		fail("Level has invalid size");
 	}
+	xorx_t *ctx = SDL_calloc(1, sizeof(xorx_t));
+	if (!ctx) {
+		SDL_DestroySurface(surface);
+		fail("Out of memory");
+	}
+	ctx->game = state.world.game;
 	for (int y = 0; y < MAP_ROWS; ++y) {
 		for (int x = 0; x < MAP_COLS; ++x) {
 			Uint8 r, g, b;
-			const vec_t v = vec2(x, y);
 			SDL_ReadSurfacePixel(surface, x, y, &r, &g, &b, NULL);
-			switch ((r << 16) | (g << 8) | b) {
-				default: /* floor */ clear(v); break;
-				case 0x4e4a4e: /* walls */ shape(v, TILE_WALL_0 + rnd()%4, 0); break;
-				case 0x8595a1: /* boulder */ shape(v, TILE_BOULDER, 0); break;
-				case 0x70402a: /* ruin */ shape(v, TILE_RUIN_0 + rnd()%2, 0); break;
-				case 0x004000: /* tree */ shape(v, TILE_TREE_0 + rnd()%2, 0); break;
-				case 0x4a2a1b: /* dead tree */ shape(v, TILE_TREE_2 + rnd()%2, 0); break;
-				case 0x008000: /* grass*/ shape(v, TILE_GRASS_0 + rnd()%2, 0); break;
-				case 0x000096: /* water */ shape(v, TILE_WATER_0 + rnd()%2, 16); break;
-				case 0xffffff: /* player */ shape(v, TILE_PLAYER_STAND, 1); state.game.player = v; break;
-				case 0x400000: /* monster 0 */ shape(v, TILE_MONSTER_0, 1); break;
-				case 0x800000: /* monster 1 */ shape(v, TILE_MONSTER_1, 1); break;
-				case 0xc00000: /* monster 2 */ shape(v, TILE_MONSTER_2, 1); break;
-				case 0xff0000: /* monster 3 */ shape(v, TILE_MONSTER_3, 1); break;
-				case 0xff8000: /* bolt trap */ shape(v, TILE_BOLT_TRAP_0, rnd()%16); break;
-				case 0xff6400: /* shrine */ shape(v, TILE_SHRINE_0, 30+rnd()%16); break;
-				case 0x6dc2ca: /* teleport */ shape(v, TILE_TELEPORT, 0); break;
-			}
+			spawn(ctx, vec2(x, y), (r << 16) | (g << 8) | b);
 		}
 	}
 	SDL_DestroySurface(surface);
-	state.game.view = vbase(state.game.player);
+	ctx->game.view = vbase(ctx->game.player[0]);
+	visit(ctx);
 	// place solid walls (wall x)
 	for (int y = 0; y < MAP_ROWS; ++y) {
 		for (int x = 0; x < MAP_COLS; ++x) {
 			const vec_t v = vec2(x, y);
-			if (enclosed(v)) shape(v, TILE_WALL_X, 0);
+			if (enclosed(ctx, v)) shape(ctx, v, TILE_WALL_X, 0);
+		}
+	}
+	state.world.game = ctx->game;
+	SDL_free(ctx);
+	return true;
+}
+
+// return the closest free cell around v on the same screen (invalid_position if there is none)
+static vec_t beside(xorx_t *ctx, const vec_t v) {
+	for (int r = 1; r < VIEW_COLS; ++r) {
+		for (int y = -r; y <= r; ++y) {
+			for (int x = -r; x <= r; ++x) {
+				const vec_t w = vadd(v, vec2(x, y));
+				if ((maxi(abs(x), abs(y)) == r) && veq(vbase(w), vbase(v)) && (get(ctx, w).tile == TILE_EMPTY)) return w;
+			}
+		}
+	}
+	return invalid_position;
+}
+
+// bring the other players next to the first one (new game, first player entered another screen)
+static void follow(xorx_t *ctx) {
+	const vec_t leader = ctx->game.player[0];
+	for (int i = 1; i < ctx->players; ++i) {
+		const vec_t v = ctx->game.player[i];
+		if (inside(v) && veq(vbase(v), vbase(leader))) continue;
+		if (inside(v)) clear(ctx, v);
+		ctx->game.player[i] = beside(ctx, leader);
+		if (inside(ctx->game.player[i])) shape(ctx, ctx->game.player[i], TILE_PSPAWN_0, 2);
+	}
+}
+
+// return the index of the player at the given position
+static int which(xorx_t *ctx, const vec_t v) {
+	for (int i = 1; i < ctx->players; ++i) if (veq(ctx->game.player[i], v)) return i;
+	return 0;
+}
+
+// return the position of the player closest to src
+static vec_t nearest(xorx_t *ctx, const vec_t src) {
+	vec_t best = ctx->game.player[0];
+	for (int i = 1; i < ctx->players; ++i) {
+		const vec_t v = ctx->game.player[i];
+		if (inside(v) && (vlen(vsub(v, src)) < vlen(vsub(best, src)))) best = v;
+	}
+	return best;
+}
+
+// start new game will start a completely new game
+static void start_game(xorx_t *ctx) {
+	if (ctx->journal.enabled) {
+		// only write the changed cells, so even a restart can be rolled back
+		for (int y = 0; y < MAP_ROWS; ++y) {
+			if (!memcmp(ctx->game.cells[y], state.world.game.cells[y], sizeof(ctx->game.cells[y]))) continue;
+			for (int x = 0; x < MAP_COLS; ++x) {
+				const cell_t cell = state.world.game.cells[y][x];
+				if ((ctx->game.cells[y][x].tile != cell.tile) || (ctx->game.cells[y][x].tick != cell.tick)) put(ctx, vec2(x, y), cell);
+			}
 		}
+		memcpy(&ctx->game, &state.world.game, offsetof(struct game_t, cells));
+	} else {
+		ctx->game = state.world.game;
+		memset(ctx->video.changed, 0xff, sizeof(ctx->video.changed));
+		memset(ctx->video.minimap, 0xff, sizeof(ctx->video.minimap));
 	}
+	follow(ctx);
 }
 
-// hurt the player
-static void hurt(const int damage) {
-	if (damage < state.game.life) {
-		state.game.life -= damage;
-		sound(SOUND_PLAYER_HURT);
-		shape(state.game.player, TILE_PLAYER_DEFEND, 5);
+// hurt the player at the given position (all players share their hitpoints)
+static void hurt(xorx_t *ctx, const vec_t v, const int damage) {
+	if (damage < ctx->game.life) {
+		ctx->game.life -= damage;
+		sound(ctx, SOUND_PLAYER_HURT);
+		shape(ctx, v, TILE_PLAYER_DEFEND, 5);
 	} else {
-		state.game.life = 0;
-		state.game.dead = true;
-		sound(SOUND_PLAYER_DIED);
-		explode(state.game.player);
+		ctx->game.life = 0;
+		ctx->game.dead = true;
+		sound(ctx, SOUND_PLAYER_DIED);
+		explode(ctx, v);
 	}
 }
 
 // teleport the player
-static bool teleport(const vec_t src, const dir_t dir) {
+static bool teleport(xorx_t *ctx, const int id, const vec_t src, const dir_t dir) {
 	for (vec_t dst = vmove(src, dir); inside(dst); dst = vmove(dst, dir)) {
-		if (get(dst).tile == TILE_TELEPORT) {
-			sound(SOUND_TELEPORT);
-			clear(state.game.player);
-			state.game.player = vmove(dst, dir);
-			state.game.view = vbase(state.game.player);
-			shape(state.game.player, TILE_PSPAWN_0, 2);
+		if (get(ctx, dst).tile == TILE_TELEPORT) {
+			// only the first player may leave the screen
+			if (id && !visible(ctx, vmove(dst, dir))) return false;
+			sound(ctx, SOUND_TELEPORT);
+			clear(ctx, ctx->game.player[id]);
+			ctx->game.player[id] = vmove(dst, dir);
+			if (!id) { ctx->game.view = vbase(ctx->game.player[id]); visit(ctx); }
+			shape(ctx, ctx->game.player[id], TILE_PSPAWN_0, 2);
 			return true;
 		}
 	}
@@ -485,178 +1045,180 @@ static bool teleport(const vec_t src, const dir_t dir) {
 }
 
 // push a boulder
-static bool push(const vec_t src, const dir_t dir) {
+static bool push(xorx_t *ctx, const vec_t src, const dir_t dir) {
 	const vec_t dst = vmove(src, dir);
-	switch (get(dst).tile) {
+	switch (get(ctx, dst).tile) {
 		default:
 			return false;
 		case TILE_EMPTY:
-			clear(src);
-			shape(dst, TILE_BOULDER, 0);
-			sound(SOUND_BOULDER);
+			clear(ctx, src);
+			shape(ctx, dst, TILE_BOULDER, 0);
+			sound(ctx, SOUND_BOULDER);
 			return true;
 		case TILE_MONSTER_0:
 		case TILE_MONSTER_1:
 		case TILE_MONSTER_2:
 		case TILE_MONSTER_3:
-			sound(SOUND_BOULDER);
-			sound(SOUND_MONSTER_DIED);
-			explode(dst);
+			sound(ctx, SOUND_BOULDER);
+			sound(ctx, SOUND_MONSTER_DIED);
+			explode(ctx, dst);
 			return false;
 		case TILE_WATER_0:
 		case TILE_WATER_1:
-			clear(src);
-			explode(dst);
-			sound(SOUND_BOULDER);
+			clear(ctx, src);
+			explode(ctx, dst);
+			sound(ctx, SOUND_BOULDER);
 			return false;
 	}
 }
 
 // update arrows
-static void update_arrow(const vec_t src, const dir_t dir, const bool water) {
-	if (water) shape(src, TILE_WATER_0+rnd()%2, 16+rnd()%8); else clear(src);
+static void update_arrow(xorx_t *ctx, const vec_t src, const dir_t dir, const bool water) {
+	if (water) shape(ctx, src, TILE_WATER_0+rnd(ctx)%2, 16+rnd(ctx)%8); else clear(ctx, src);
 	const vec_t dst = vmove(src, dir);
-	if (!visible(dst)) return;
-	const cell_t cell = get(dst);
+	if (!visible(ctx, dst)) return;
+	const cell_t cell = get(ctx, dst);
 	switch (cell.tile) {
 		case TILE_EMPTY:
 		case TILE_EXPLOSION_0:
 		case TILE_EXPLOSION_1:
 		case TILE_EXPLOSION_2:
 		case TILE_EXPLOSION_3:
-			shape(dst, TILE_ARROW_N + dir - 1, 2);
+			shape(ctx, dst, TILE_ARROW_N + dir - 1, 2);
 			break;
 		case TILE_WATER_0:
 		case TILE_WATER_1:
-			shape(dst, TILE_WARROW_N + dir - 1, 2);
+			shape(ctx, dst, TILE_WARROW_N + dir - 1, 2);
 			break;
 		case TILE_MONSTER_0:
-			sound(SOUND_MONSTER_DIED);
-			explode(dst);
+			sound(ctx, SOUND_MONSTER_DIED);
+			explode(ctx, dst);
 			break;
 		case TILE_MONSTER_1:
 		case TILE_MONSTER_2:
 		case TILE_MONSTER_3:
-			sound(SOUND_MONSTER_HURT);
-			put(dst, (cell_t){ .tile = cell.tile - 1, .tick = cell.tick });
+			sound(ctx, SOUND_MONSTER_HURT);
+			put(ctx, dst, (cell_t){ .tile = cell.tile - 1, .tick = cell.tick });
 			break;
 		case TILE_GRASS_0:
 		case TILE_GRASS_1:
 		case TILE_RUIN_0:
 		case TILE_RUIN_1:
-			explode(dst);
+			explode(ctx, dst);
 			break;
 	}
 }
 
 // update bolts
-static void update_bolt(const vec_t src, const dir_t dir, const bool water) {
-	if (water) shape(src, TILE_WATER_0+rnd()%2, 16+rnd()%8); else clear(src);
+static void update_bolt(xorx_t *ctx, const vec_t src, const dir_t dir, const bool water) {
+	if (water) shape(ctx, src, TILE_WATER_0+rnd(ctx)%2, 16+rnd(ctx)%8); else clear(ctx, src);
 	const vec_t dst = vmove(src, dir);
-	if (!visible(dst)) return;
-	const cell_t cell = get(dst);
+	if (!visible(ctx, dst)) return;
+	const cell_t cell = get(ctx, dst);
 	switch (cell.tile) {
 		case TILE_EMPTY:
 		case TILE_EXPLOSION_0:
 		case TILE_EXPLOSION_1:
 		case TILE_EXPLOSION_2:
 		case TILE_EXPLOSION_3:
-			shape(dst, TILE_BOLT_N + dir - 1, 2);
+			shape(ctx, dst, TILE_BOLT_N + dir - 1, 2);
 			break;
 		case TILE_WATER_0:
 		case TILE_WATER_1:
-			shape(dst, TILE_WBOLT_N + dir - 1, 2);
+			shape(ctx, dst, TILE_WBOLT_N + dir - 1, 2);
 			break;
 		case TILE_MONSTER_0:
-			sound(SOUND_MONSTER_DIED);
-			explode(dst);
+			sound(ctx, SOUND_MONSTER_DIED);
+			explode(ctx, dst);
 			break;
 		case TILE_MONSTER_1:
 		case TILE_MONSTER_2:
 		case TILE_MONSTER_3:
-			sound(SOUND_MONSTER_HURT);
-			put(dst, (cell_t){ .tile = cell.tile - 1, .tick = cell.tick });
+			sound(ctx, SOUND_MONSTER_HURT);
+			put(ctx, dst, (cell_t){ .tile = cell.tile - 1, .tick = cell.tick });
 			break;
 		case TILE_PLAYER_STAND:
 		case TILE_PLAYER_SHOOT:
 		case TILE_PLAYER_MAGIC:
 		case TILE_PLAYER_DEFEND:
-			hurt(5);
+			hurt(ctx, dst, 5);
 			break;
 	}
 }
 
 // update the bolt trap
-static void update_bolt_trap(const vec_t src, const cell_t cell) {
+static void update_bolt_trap(xorx_t *ctx, const vec_t src, const cell_t cell) {
 	if (cell.tile == TILE_BOLT_TRAP_0) {
-		shape(src, TILE_BOLT_TRAP_1, 4);
+		shape(ctx, src, TILE_BOLT_TRAP_1, 4);
 	} else {
-		sound(SOUND_SHOOT_BOLT);
-		for (dir_t dir = DIR_NORTH; dir <= DIR_WEST; ++dir) update_bolt(src, dir, false);
-		shape(src, TILE_BOLT_TRAP_0, 30-4);
+		sound(ctx, SOUND_SHOOT_BOLT);
+		for (dir_t dir = DIR_NORTH; dir <= DIR_WEST; ++dir) update_bolt(ctx, src, dir, false);
+		shape(ctx, src, TILE_BOLT_TRAP_0, 30-4);
 	}
 }
 
 // update monster shrine
-static void update_shrine(const vec_t src, const cell_t cell) {
+static void update_shrine(xorx_t *ctx, const vec_t src, const cell_t cell) {
 	if (cell.tile == TILE_SHRINE_3) {
-		shape(src, TILE_SHRINE_0, 60);
-		const vec_t dst = vmove(src, random_dir());
-		if (get(dst).tile == TILE_EMPTY) {
-			sound(SOUND_SPAWN);
-			shape(dst, TILE_SPAWN_0, 2);
+		shape(ctx, src, TILE_SHRINE_0, 60);
+		const vec_t dst = vmove(src, random_dir(ctx));
+		if (get(ctx, dst).tile == TILE_EMPTY) {
+			sound(ctx, SOUND_SPAWN);
+			shape(ctx, dst, TILE_SPAWN_0, 2);
 		}
 	} else {
-		shape(src, cell.tile + 1, 60);
+		shape(ctx, src, cell.tile + 1, 60);
 	}
 }
 
 // update monster
-static void update_monster(const vec_t src, const cell_t cell) {
-	const vec_t dst = vmove(src, chase_dir(src, state.game.player));
-	switch (get(dst).tile) {
+static void update_monster(xorx_t *ctx, const vec_t src, const cell_t cell) {
+	const vec_t dst = vmove(src, chase_dir(ctx, src, nearest(ctx, src)));
+	switch (get(ctx, dst).tile) {
 		case TILE_EMPTY:
-			clear(src);
-			shape(dst, cell.tile, 16);
+			clear(ctx, src);
+			shape(ctx, dst, cell.tile, 16);
 			break;
 		case TILE_PLAYER_STAND:
 		case TILE_PLAYER_SHOOT:
 		case TILE_PLAYER_MAGIC:
 		case TILE_PLAYER_DEFEND:
-			hurt(cell.tile - TILE_MONSTER_0 + 1);
-			explode(src);
-			shape(dst, TILE_PLAYER_DEFEND, 5);
+			hurt(ctx, dst, cell.tile - TILE_MONSTER_0 + 1);
+			explode(ctx, src);
+			shape(ctx, dst, TILE_PLAYER_DEFEND, 5);
 			break;
 		default:
-			shape(src, cell.tile, 16);
+			shape(ctx, src, cell.tile, 16);
 			break;
 	}
 }
 
 // update player
-static void update_player(const vec_t src) {
-	const dir_t dir = input_dir();
+static void update_player(xorx_t *ctx, const int id, const vec_t src) {
+	const dir_t dir = input_dir(ctx, id);
 	const vec_t dst = vmove(src, dir);
 
 	// shoot
-	if (btn(BUTTON_A)) {
+	if (btn(ctx, id, BUTTON_A)) {
 		if (dir != DIR_NONE) {
-			sound(SOUND_SHOOT);
-			update_arrow(src, dir, false);
-			shape(src, TILE_PLAYER_SHOOT, 20);
+			sound(ctx, SOUND_SHOOT);
+			update_arrow(ctx, src, dir, false);
+			shape(ctx, src, TILE_PLAYER_SHOOT, 20);
 			return;
 		}
-		shape(src, TILE_PLAYER_SHOOT, 1);
+		shape(ctx, src, TILE_PLAYER_SHOOT, 1);
 		return;
 	}
 
 	// walk
 	if (dir == DIR_NONE) {
-		shape(src, TILE_PLAYER_STAND, 1);
-		state.game.player = src;
+		shape(ctx, src, TILE_PLAYER_STAND, 1);
+		ctx->game.player[id] = src;
 		return;
 	}
-	const cell_t cell = get(dst);
+	// only the first player may leave the screen, the others follow
+	if (id && !visible(ctx, dst)) goto blocked;
+	const cell_t cell = get(ctx, dst);
 	switch (cell.tile) {
 		default:
 			goto blocked;
@@ -664,401 +1226,2944 @@ static void update_player(const vec_t src) {
 			break;
 		case TILE_GRASS_0:
 		case TILE_GRASS_1:
-			explode(dst);
+			explode(ctx, dst);
 			goto blocked;
 		case TILE_MONSTER_0:
 		case TILE_MONSTER_1:
 		case TILE_MONSTER_2:
 		case TILE_MONSTER_3:
-			hurt(cell.tile - TILE_MONSTER_0 + 1);
-			sound(SOUND_MONSTER_DIED);
-			explode(dst);
+			hurt(ctx, src, cell.tile - TILE_MONSTER_0 + 1);
+			sound(ctx, SOUND_MONSTER_DIED);
+			explode(ctx, dst);
 			goto blocked;
 		case TILE_TELEPORT:
-			if (teleport(dst, dir)) return;
+			if (teleport(ctx, id, dst, dir)) return;
 			goto blocked;
 		case TILE_BOULDER:
-			if (!push(dst, dir)) goto blocked;
-			clear(src);
-			shape(dst, TILE_PLAYER_STAND, 10);
-			sound(SOUND_PLAYER_MOVED);
+			if (!push(ctx, dst, dir)) goto blocked;
+			clear(ctx, src);
+			shape(ctx, dst, TILE_PLAYER_STAND, 10);
+			sound(ctx, SOUND_PLAYER_MOVED);
+			ctx->game.player[id] = dst;
 			return;
 		case TILE_LIFE:
-			state.game.life = mini(999, state.game.life + 5);
-			sound(SOUND_PICKUP);
+			ctx->game.life = mini(999, ctx->game.life + 5);
+			sound(ctx, SOUND_PICKUP);
 			break;
 		case TILE_AMMO:
-			state.game.ammo = mini(999, state.game.ammo + 5);
-			sound(SOUND_PICKUP);
+			ctx->game.ammo = mini(999, ctx->game.ammo + 5);
+			sound(ctx, SOUND_PICKUP);
 			break;
 		case TILE_FLASK:
-			state.game.flasks = mini(999, state.game.flasks + 1);
-			sound(SOUND_PICKUP);
+			ctx->game.flasks = mini(999, ctx->game.flasks + 1);
+			sound(ctx, SOUND_PICKUP);
 			break;
 	}
 
 	// move player to new position
-	clear(src);
-	shape(dst, TILE_PLAYER_STAND, 5);
-	sound(SOUND_PLAYER_MOVED);
-	state.game.player = dst;
+	clear(ctx, src);
+	shape(ctx, dst, TILE_PLAYER_STAND, 5);
+	sound(ctx, SOUND_PLAYER_MOVED);
+	ctx->game.player[id] = dst;
 	return;
 
 blocked:
 	// movement was blocked
-	shape(src, TILE_PLAYER_STAND, 1);
-	sound(SOUND_PLAYER_BLOCKED);
-	state.game.player = src;
+	shape(ctx, src, TILE_PLAYER_STAND, 1);
+	sound(ctx, SOUND_PLAYER_BLOCKED);
+	ctx->game.player[id] = src;
 	return;
 }
 
 // handle single cell
-static void update_cell(const vec_t v) {
-	const cell_t cell = get(v);
-	if (cell.tick != state.game.tick) return;
+static void update_cell(xorx_t *ctx, const vec_t v) {
+	const cell_t cell = get(ctx, v);
+	if (cell.tick != ctx->game.tick) return;
 	switch (cell.tile) {
 		// player
 		case TILE_PLAYER_STAND:
 		case TILE_PLAYER_SHOOT:
 		case TILE_PLAYER_MAGIC:
 		case TILE_PLAYER_DEFEND:
-			update_player(v);
+			update_player(ctx, which(ctx, v), v);
 			break;
 		// monsters
 		case TILE_MONSTER_0:
 		case TILE_MONSTER_1:
 		case TILE_MONSTER_2:
 		case TILE_MONSTER_3:
-			update_monster(v, cell);
+			update_monster(ctx, v, cell);
 			break;
 		// arrows
-		case TILE_ARROW_N: update_arrow(v, DIR_NORTH, false); break;
-		case TILE_ARROW_E: update_arrow(v, DIR_EAST, false); break;
-		case TILE_ARROW_S: update_arrow(v, DIR_SOUTH, false); break;
-		case TILE_ARROW_W: update_arrow(v, DIR_WEST, false); break;
-		case TILE_WARROW_N: update_arrow(v, DIR_NORTH, true); break;
-		case TILE_WARROW_E: update_arrow(v, DIR_EAST, true); break;
-		case TILE_WARROW_S: update_arrow(v, DIR_SOUTH, true); break;
-		case TILE_WARROW_W: update_arrow(v, DIR_WEST, true); break;
+		case TILE_ARROW_N: update_arrow(ctx, v, DIR_NORTH, false); break;
+		case TILE_ARROW_E: update_arrow(ctx, v, DIR_EAST, false); break;
+		case TILE_ARROW_S: update_arrow(ctx, v, DIR_SOUTH, false); break;
+		case TILE_ARROW_W: update_arrow(ctx, v, DIR_WEST, false); break;
+		case TILE_WARROW_N: update_arrow(ctx, v, DIR_NORTH, true); break;
+		case TILE_WARROW_E: update_arrow(ctx, v, DIR_EAST, true); break;
+		case TILE_WARROW_S: update_arrow(ctx, v, DIR_SOUTH, true); break;
+		case TILE_WARROW_W: update_arrow(ctx, v, DIR_WEST, true); break;
 		// bolts
-		case TILE_BOLT_N: update_bolt(v, DIR_NORTH, false); break;
-		case TILE_BOLT_E: update_bolt(v, DIR_EAST, false); break;
-		case TILE_BOLT_S: update_bolt(v, DIR_SOUTH, false); break;
-		case TILE_BOLT_W: update_bolt(v, DIR_WEST, false); break;
-		case TILE_WBOLT_N: update_bolt(v, DIR_NORTH, true); break;
-		case TILE_WBOLT_E: update_bolt(v, DIR_EAST, true); break;
-		case TILE_WBOLT_S: update_bolt(v, DIR_SOUTH, true); break;
-		case TILE_WBOLT_W: update_bolt(v, DIR_WEST, true); break;
+		case TILE_BOLT_N: update_bolt(ctx, v, DIR_NORTH, false); break;
+		case TILE_BOLT_E: update_bolt(ctx, v, DIR_EAST, false); break;
+		case TILE_BOLT_S: update_bolt(ctx, v, DIR_SOUTH, false); break;
+		case TILE_BOLT_W: update_bolt(ctx, v, DIR_WEST, false); break;
+		case TILE_WBOLT_N: update_bolt(ctx, v, DIR_NORTH, true); break;
+		case TILE_WBOLT_E: update_bolt(ctx, v, DIR_EAST, true); break;
+		case TILE_WBOLT_S: update_bolt(ctx, v, DIR_SOUTH, true); break;
+		case TILE_WBOLT_W: update_bolt(ctx, v, DIR_WEST, true); break;
 		// bolt trap
 		case TILE_BOLT_TRAP_0:
 		case TILE_BOLT_TRAP_1:
-			update_bolt_trap(v, cell);
+			update_bolt_trap(ctx, v, cell);
 			break;
 		// water
-		case TILE_WATER_0: shape(v, TILE_WATER_1, 16 + rnd()%8); break;
-		case TILE_WATER_1: shape(v, TILE_WATER_0, 16+rnd()%8); break;
+		case TILE_WATER_0: shape(ctx, v, TILE_WATER_1, 16 + rnd(ctx)%8); break;
+		case TILE_WATER_1: shape(ctx, v, TILE_WATER_0, 16+rnd(ctx)%8); break;
 		// explosions
-		case TILE_EXPLOSION_0: shape(v, TILE_EXPLOSION_1, 2); break;
-		case TILE_EXPLOSION_1: shape(v, TILE_EXPLOSION_2, 2); break;
-		case TILE_EXPLOSION_2: shape(v, TILE_EXPLOSION_3, 2); break;
-		case TILE_EXPLOSION_3: clear(v); break;
+		case TILE_EXPLOSION_0: shape(ctx, v, TILE_EXPLOSION_1, 2); break;
+		case TILE_EXPLOSION_1: shape(ctx, v, TILE_EXPLOSION_2, 2); break;
+		case TILE_EXPLOSION_2: shape(ctx, v, TILE_EXPLOSION_3, 2); break;
+		case TILE_EXPLOSION_3: clear(ctx, v); break;
 		// spawns
-		case TILE_SPAWN_0: shape(v, TILE_SPAWN_1, 2); break;
-		case TILE_SPAWN_1: shape(v, TILE_SPAWN_2, 2); break;
-		case TILE_SPAWN_2: shape(v, TILE_SPAWN_3, 2); break;
-		case TILE_SPAWN_3: shape(v, TILE_MONSTER_0+rnd()%4, 10); break;
-		case TILE_PSPAWN_0: shape(v, TILE_PSPAWN_1, 2); break;
-		case TILE_PSPAWN_1: shape(v, TILE_PSPAWN_2, 2); break;
-		case TILE_PSPAWN_2: shape(v, TILE_PSPAWN_3, 2); break;
-		case TILE_PSPAWN_3: shape(v, TILE_PLAYER_STAND, 1); break;
+		case TILE_SPAWN_0: shape(ctx, v, TILE_SPAWN_1, 2); break;
+		case TILE_SPAWN_1: shape(ctx, v, TILE_SPAWN_2, 2); break;
+		case TILE_SPAWN_2: shape(ctx, v, TILE_SPAWN_3, 2); break;
+		case TILE_SPAWN_3: shape(ctx, v, TILE_MONSTER_0+rnd(ctx)%4, 10); break;
+		case TILE_PSPAWN_0: shape(ctx, v, TILE_PSPAWN_1, 2); break;
+		case TILE_PSPAWN_1: shape(ctx, v, TILE_PSPAWN_2, 2); break;
+		case TILE_PSPAWN_2: shape(ctx, v, TILE_PSPAWN_3, 2); break;
+		case TILE_PSPAWN_3: shape(ctx, v, TILE_PLAYER_STAND, 1); break;
 		// shrines
 		case TILE_SHRINE_0:
 		case TILE_SHRINE_1:
 		case TILE_SHRINE_2:
 		case TILE_SHRINE_3:
-			update_shrine(v, cell);
+			update_shrine(ctx, v, cell);
 			break;
 	}
 }
 
 // update the whole game
-static void update_game(void) {
+static void update_game(xorx_t *ctx) {
 	// check for dead
-	if (state.game.dead && btnp(BUTTON_A)) start_game();
+	if (ctx->game.dead && btnp(ctx, BUTTON_A)) start_game(ctx);
 
 	// check for pause
-	if (!state.game.dead && btnp(BUTTON_X)) state.game.paused = !state.game.paused;
-	if (state.game.paused) return;
-
-	// check if we have to move the screen
-	const vec_t base = vbase(state.game.player);
-	if (!veq(base, state.game.view)) {
-		if (state.game.view.x < base.x) state.game.view.x += 2;
-		if (state.game.view.x > base.x) state.game.view.x -= 2;
-		if (state.game.view.y < base.y) state.game.view.y += 1;
-		if (state.game.view.y > base.y) state.game.view.y -= 1;
-		return;
-	}
+	if (!ctx->game.dead && btnp(ctx, BUTTON_X)) ctx->game.paused = !ctx->game.paused;
+	if (ctx->game.paused) return;
 
 	// update the visible part of the map
+	const vec_t base = ctx->game.view;
 	for (int y = 0; y < VIEW_ROWS; ++y) {
 		for (int x = 0; x < VIEW_COLS; ++x) {
-			update_cell(vadd(base, vec2(x, y)));
+			update_cell(ctx, vadd(base, vec2(x, y)));
 		}
 	}
 
 	// check if we have left the screen
-	if (!veq(base, vbase(state.game.player))) {
+	if (!veq(base, vbase(ctx->game.player[0]))) {
 		// hibernate the old screen
 		for (int y = 0; y < VIEW_ROWS; ++y) {
 			for (int x = 0; x < VIEW_COLS; ++x) {
-				hibernate(vadd(base, vec2(x, y)));
+				hibernate(ctx, vadd(base, vec2(x, y)));
 			}
 		}
-		hibernate(state.game.player);
-		state.game.tick = 0;
+		hibernate(ctx, ctx->game.player[0]);
+		ctx->game.tick = 0;
+		follow(ctx);
+		// the view jumps to the new screen right away, the renderer scrolls there smoothly
+		ctx->game.view = vbase(ctx->game.player[0]);
+		visit(ctx);
 	} else {
-		state.game.tick++;
+		ctx->game.tick++;
 	}
 }
 
 // draw the whole game
-static void draw_game(void) {
-	cls(); border(0, VIEW_ROWS, VIDEO_COLS - 1, VIEW_ROWS);
+static void draw_game(xorx_t *ctx) {
+	cls(ctx); border(ctx, 0, VIEW_ROWS, VIDEO_COLS - 1, VIEW_ROWS);
 	// draw play screen
 	for (int y = 0; y < VIEW_ROWS; ++y) {
 		for (int x = 0; x < VIEW_COLS; ++x) {
-			const cell_t cell = get(vadd(state.game.view, vec2(x, y)));
-			draw(x, y, cell.tile);
+			const cell_t cell = get(ctx, vadd(ctx->game.view, vec2(x, y)));
+			draw(ctx, x, y, cell.tile);
 		}
 	}
 	// draw hud
-	center(VIDEO_ROWS - 1, strf("%c%-3d %c%-3d %c%-3d",
-		TILE_LIFE, state.game.life,
-		TILE_AMMO, state.game.ammo,
-		TILE_FLASK, state.game.flasks
+	center(ctx, VIDEO_ROWS - 1, strf("%c%-3d %c%-3d %c%-3d",
+		TILE_LIFE, ctx->game.life,
+		TILE_AMMO, ctx->game.ammo,
+		TILE_FLASK, ctx->game.flasks
 	));
-	if (state.game.dead) {
-		center(VIDEO_ROWS - 2, "\01 YOU DIED! \01");
-	} else if (state.game.paused) {
+	if (ctx->game.dead) {
+		center(ctx, VIDEO_ROWS - 2, "\01 YOU DIED! \01");
+	} else if (ctx->game.paused) {
 		const int x0 = (VIDEO_COLS - (MAP_COLS / VIEW_COLS / 2)) / 2;
 		const int y0 = (VIDEO_ROWS - (MAP_ROWS / VIEW_ROWS / 2)) / 2 - 1;
-		border(x0 - 1, y0 - 1, x0 + (MAP_COLS / VIDEO_COLS / 2), y0 + (MAP_ROWS / VIEW_ROWS / 2));
+		border(ctx, x0 - 1, y0 - 1, x0 + (MAP_COLS / VIDEO_COLS / 2), y0 + (MAP_ROWS / VIEW_ROWS / 2));
+		// every map tile covers 2 x 2 screens, it only shows up once one of them was visited
 		for (int y = 0; y < MAP_ROWS / VIEW_ROWS / 2; ++y) {
 			for (int x = 0; x < MAP_COLS / VIEW_COLS / 2; ++x) {
-				draw(x0 + x, y0 + y, TILE_MAP_0);
+				const int screen = screen_index(vec2(x * 2 * VIEW_COLS, y * 2 * VIEW_ROWS)), row = MAP_COLS / VIEW_COLS;
+				const uint64_t mask = (3ull << (screen % 64)) | (3ull << ((screen + row) % 64));
+				draw(ctx, x0 + x, y0 + y, (ctx->game.visited[screen / 64] & mask) ? TILE_MAP_0 : TILE_EMPTY);
 			}
 		}
-		const vec_t v = vec2(state.game.player.x / VIEW_COLS, state.game.player.y / VIEW_ROWS);
-		draw(x0 + v.x / 2, y0 + v.y / 2, TILE_MAP_1 + (v.y % 2) * 2 + (v.x % 2));
+		const vec_t v = vec2(ctx->game.player[0].x / VIEW_COLS, ctx->game.player[0].y / VIEW_ROWS);
+		draw(ctx, x0 + v.x / 2, y0 + v.y / 2, TILE_MAP_1 + (v.y % 2) * 2 + (v.x % 2));
 	}
 }
 
 // initialize the game
-static void on_init(void) {
-	start_game();
+static void on_init(xorx_t *ctx) {
+	start_game(ctx);
 }
 
 // run single game tick
-static void on_tick(void) {
-	update_game();
-	draw_game();
+static void on_tick(xorx_t *ctx) {
+	update_game(ctx);
+	draw_game(ctx);
 }
 
-
-//==[[ Core Engine Routines ]]==========================================================================================
-
-// screenshot will take a screenshot
-static void screenshot(void) {
-	SDL_Surface *tileset = SDL_LoadBMP("tiles.bmp");
-	SDL_Surface *surface = SDL_CreateSurface(VIDEO_WIDTH * 3, VIDEO_HEIGHT * 3, SDL_PIXELFORMAT_RGB24);
-	for (int y = 0; y < VIDEO_ROWS; ++y) {
-		for (int x = 0; x < VIDEO_COLS; ++x) {
-			const unsigned int tile = state.video.data[y][x];
-			const SDL_Rect src = { .x = (tile % 16) * TILE_WIDTH, .y = (tile / 16) * TILE_HEIGHT, .w = TILE_WIDTH, .h = TILE_HEIGHT };
-			const SDL_Rect dst = { .x = x * TILE_WIDTH * 3, .y = y * TILE_HEIGHT * 3, .w = TILE_WIDTH * 3, .h = TILE_HEIGHT * 3 };
-			SDL_BlitSurfaceScaled(tileset, &src, surface, &dst, SDL_SCALEMODE_NEAREST);
-		}
-	}
-	SDL_SaveBMP(surface, "screenshot.bmp");
-	SDL_DestroySurface(surface);
-	SDL_DestroySurface(tileset);
+// advance the instance by a single tick
+static void step(xorx_t *ctx) {
+	on_tick(ctx);
+	ctx->time.tick++;
+	memcpy(ctx->input.prev, ctx->input.down, sizeof(ctx->input.prev));
 }
 
-// press will set/unset a button
-static void press(const btn_t mask, const bool down) {
-	if (down) state.input.down |= mask; else state.input.down &= ~mask;
-}
 
-// handle keyboard keys
-static void handle_keyboard(const SDL_Keycode key, const bool down) {
-	switch (key) {
-		case SDLK_ESCAPE: if (down) state.core.running = false; break;
-		case SDLK_F12: if (down) screenshot(); break;
-		case SDLK_W: case SDLK_8: case SDLK_KP_8: case SDLK_UP: press(BUTTON_UP, down); break;
-		case SDLK_S: case SDLK_2: case SDLK_KP_2: case SDLK_DOWN: press(BUTTON_DOWN, down); break;
-		case SDLK_A: case SDLK_4: case SDLK_KP_4: case SDLK_LEFT: press(BUTTON_LEFT, down); break;
-		case SDLK_D: case SDLK_6: case SDLK_KP_6: case SDLK_RIGHT: press(BUTTON_RIGHT, down); break;
-		case SDLK_I: case SDLK_RETURN: case SDLK_RETURN2: press(BUTTON_A, down); break;
-		case SDLK_O: case SDLK_SPACE: press(BUTTON_B, down); break;
-		case SDLK_K: press(BUTTON_X, down); break;
-		case SDLK_L: press(BUTTON_Y, down); break;
-	}
-}
+//==[[ Worker Pool ]]===================================================================================================
 
-// handle gamepad buttons
-static void handle_gamepad(const int button, const bool down) {
-	switch (button) {
-		case SDL_GAMEPAD_BUTTON_DPAD_UP: press(BUTTON_UP, down); break;
-		case SDL_GAMEPAD_BUTTON_DPAD_DOWN: press(BUTTON_DOWN, down); break;
-		case SDL_GAMEPAD_BUTTON_DPAD_LEFT: press(BUTTON_LEFT, down); break;
-		case SDL_GAMEPAD_BUTTON_DPAD_RIGHT: press(BUTTON_RIGHT, down); break;
-		case SDL_GAMEPAD_BUTTON_NORTH: press(BUTTON_Y, down); break;
-		case SDL_GAMEPAD_BUTTON_SOUTH: press(BUTTON_A, down); break;
-		case SDL_GAMEPAD_BUTTON_WEST: press(BUTTON_X, down); break;
-		case SDL_GAMEPAD_BUTTON_EAST: press(BUTTON_Y, down); break;
+// work through our own slice, then steal the items left in the other slices
+static void work(const int worker) {
+	for (int i = 0; i < state.pool.count; ++i) {
+		slice_t *slice = &state.pool.slices[(worker + i) % state.pool.count];
+		for (int item; (item = SDL_AddAtomicInt(&slice->next, 1)) < slice->end;) state.pool.job(state.pool.data, item);
 	}
 }
 
-// update timer and ticks
-static void update_ticks(void) {
-	const uint64_t now = SDL_GetTicks();
-	state.time.accu += now - state.time.last;
-	state.time.last = now;
-	for (; state.time.accu >= TICK_TIME; state.time.accu -= TICK_TIME) {
-		on_tick();
-		state.time.tick++;
-		state.input.prev = state.input.down;
+// background worker thread
+static int worker_thread(void *data) {
+	const int worker = (int)(intptr_t)data;
+	unsigned int generation = 0;
+	SDL_LockMutex(state.pool.mutex);
+	for (;;) {
+		while (!state.pool.quit && (state.pool.generation == generation)) SDL_WaitCondition(state.pool.wake, state.pool.mutex);
+		if (state.pool.quit) break;
+		generation = state.pool.generation;
+		SDL_UnlockMutex(state.pool.mutex);
+		work(worker);
+		SDL_LockMutex(state.pool.mutex);
+		if (--state.pool.busy == 0) SDL_SignalCondition(state.pool.done);
 	}
+	SDL_UnlockMutex(state.pool.mutex);
+	return 0;
 }
 
-// update the audio stream
-static void update_audio(void) {
-	// check the playing bit-mask and place sound effects into the mixer channels
-	if (state.audio.playing) {
-		for (int i = 0, j = 0; (i < AUDIO_SOUNDS) && (j < AUDIO_VOICES); ++i) {
-			if ((state.audio.playing & (1 << i)) == 0) continue;
-			const sound_t sound = state.audio.sounds[i];
-			if (!sound.samples) continue;
-			for (; j < AUDIO_VOICES; ++j) {
-				voice_t *voice = &state.audio.voices[j];
-				if (!voice->sound.samples) { *voice = (voice_t){ .sound = sound }; ++j; break; }
-			}
-		}
-		state.audio.playing = 0;
-	}
-	// check if we have to "render" more audio data
-	if (SDL_GetAudioStreamAvailable(state.audio.stream) < (int)(AUDIO_BUFFER * sizeof(int16_t))) {
-		int16_t buffer[AUDIO_BUFFER];
-		for (int i = 0; i < AUDIO_BUFFER; ++i) {
-			int total = 0;
-			for (int j = 0; j < AUDIO_VOICES; ++j) {
-				voice_t *voice = &state.audio.voices[j];
-				if (voice->sound.samples) {
-					if (voice->position < voice->sound.length) {
-						total += voice->sound.samples[voice->position++];
-					} else {
-						*voice = (voice_t){};
-					}
-				}
-			}
-			buffer[i] = (int16_t)clampi(total, -32768, 32767);
-		}
-		if (!SDL_PutAudioStreamData(state.audio.stream, buffer, sizeof(buffer))) fail("SDL_PutAudioStreamData() error: %s", SDL_GetError());
+// start the worker threads on first use
+static bool start_pool(void) {
+	if (state.pool.count) return state.pool.count > 1;
+	state.pool.count = 1;
+	if (!(state.pool.mutex = SDL_CreateMutex())) return false;
+	if (!(state.pool.wake = SDL_CreateCondition())) return false;
+	if (!(state.pool.done = SDL_CreateCondition())) return false;
+	const int cores = clampi(SDL_GetNumLogicalCPUCores(), 1, POOL_WORKERS);
+	for (int i = 1; i < cores; ++i) {
+		if (!(state.pool.threads[i] = SDL_CreateThread(worker_thread, "worker", (void*)(intptr_t)i))) break;
+		state.pool.count++;
 	}
+	return state.pool.count > 1;
 }
 
-// update video rendering
-static void update_video(void) {
-	if (!SDL_RenderClear(state.video.renderer)) fail("SDL_RenderClear() error: %s", SDL_GetError());
-	for (int y = 0; y < VIDEO_ROWS; ++y) {
-		for (int x = 0; x < VIDEO_COLS; ++x) {
-			const unsigned int tile = state.video.data[y][x];
-			const SDL_FRect src = { .x = (unsigned int)((tile % 16) * TILE_WIDTH), .y = (unsigned int)((tile / 16) * TILE_HEIGHT), .w = TILE_WIDTH, .h = TILE_HEIGHT };
-			const SDL_FRect dst = { .x = x * TILE_WIDTH, .y = y * TILE_HEIGHT, .w = TILE_WIDTH, .h = TILE_HEIGHT };
-			SDL_RenderTexture(state.video.renderer, state.video.texture, &src, &dst);
-		}
+// stop all worker threads
+static void stop_pool(void) {
+	if (state.pool.mutex) {
+		SDL_LockMutex(state.pool.mutex);
+		state.pool.quit = true;
+		SDL_BroadcastCondition(state.pool.wake);
+		SDL_UnlockMutex(state.pool.mutex);
+		for (int i = 1; i < state.pool.count; ++i) SDL_WaitThread(state.pool.threads[i], NULL);
+		SDL_DestroyMutex(state.pool.mutex);
 	}
-	if (!SDL_RenderPresent(state.video.renderer)) fail("SDL_RenderPresent() error: %s", SDL_GetError());
+	if (state.pool.wake) SDL_DestroyCondition(state.pool.wake);
+	if (state.pool.done) SDL_DestroyCondition(state.pool.done);
+	state.pool.count = 0; state.pool.quit = false;
+	state.pool.mutex = NULL; state.pool.wake = state.pool.done = NULL;
 }
 
-// load tileset
-static SDL_Texture *load_tiles(const char *name) {
-	SDL_Surface *surface = SDL_LoadBMP(name);
-	if (!surface) return NULL;
-	if ((surface->w != 16 * TILE_WIDTH) || (surface->h != 16 * TILE_HEIGHT)) {
-		SDL_DestroySurface(surface);
-		fail("Tiles(%s) has wrong size");
+// run job(data, i) for every i in [0, count) on all workers, returns when all items are done
+static void parallel(const job_t job, void *data, const int count) {
+	if ((count < 2) || !start_pool()) {
+		for (int i = 0; i < count; ++i) job(data, i);
+		return;
 	}
-	Uint8 r, g, b;
-	if (SDL_ReadSurfacePixel(surface, 0, 0, &r, &g, &b, NULL)) SDL_SetRenderDrawColor(state.video.renderer, r, g, b, 255);
-	SDL_Texture *texture = SDL_CreateTextureFromSurface(state.video.renderer, surface);
-	SDL_DestroySurface(surface);
-	if (!texture) fail("SDL_CreateTextureFromSurface() error: %s", SDL_GetError());
-	if (!SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST)) fail("SDL_SetTextureScaleMode() error: %s", SDL_GetError());
-	return texture;
-}
-
-// load sound effect
-static sound_t load_sound(const char *name) {
-	SDL_AudioSpec spec; Uint8 *data; Uint32 length;
-	if (!SDL_LoadWAV(name, &spec, &data, &length)) return (sound_t){};
-	if ((spec.format != SDL_AUDIO_S16) || (spec.freq != AUDIO_RATE) || (spec.channels != 1)) {
-		SDL_free(data);
-		fail("Sound(%s) has wrong format", name);
+	const int workers = state.pool.count;
+	for (int i = 0; i < workers; ++i) {
+		SDL_SetAtomicInt(&state.pool.slices[i].next, (int)((int64_t)count * i / workers));
+		state.pool.slices[i].end = (int)((int64_t)count * (i + 1) / workers);
 	}
-	return (sound_t){ .samples = (int16_t*)data, .length = length / sizeof(int16_t) };
+	SDL_LockMutex(state.pool.mutex);
+	state.pool.job = job;
+	state.pool.data = data;
+	state.pool.busy = workers - 1;
+	state.pool.generation++;
+	SDL_BroadcastCondition(state.pool.wake);
+	SDL_UnlockMutex(state.pool.mutex);
+	work(0);
+	SDL_LockMutex(state.pool.mutex);
+	while (state.pool.busy > 0) SDL_WaitCondition(state.pool.done, state.pool.mutex);
+	SDL_UnlockMutex(state.pool.mutex);
 }
 
-// callback to initialize the application
-SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
-	(void)appstate; (void)argc; (void)argv;
-	// init core system
-	state = (struct state_t){ .core.running = true };
-	if (setjmp(state.core.error)) return SDL_APP_FAILURE;
-	if (!SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_GAMEPAD | SDL_INIT_EVENTS)) fail("SDL_Init() error: %s", SDL_GetError());
 
-	// init video system
-	int w = VIDEO_WIDTH, h = VIDEO_HEIGHT;
-	const SDL_DisplayMode *dm = SDL_GetDesktopDisplayMode(1);
-	if (dm) {
-		const int factor = maxi(1, mini((dm->w * WINDOW_SCALE) / VIDEO_WIDTH, (dm->h * WINDOW_SCALE) / VIDEO_HEIGHT));
-		w *= factor; h *= factor;
-	}
-	if (!(state.video.window = SDL_CreateWindow(WINDOW_TITLE, w, h, SDL_WINDOW_RESIZABLE))) fail("SDL_CreateWindow() error: %s", SDL_GetError());
-	if (!(state.video.renderer = SDL_CreateRenderer(state.video.window, NULL))) fail("SDL_CreateRenderer() error: %s", SDL_GetError());
-	if (!SDL_SetRenderVSync(state.video.renderer, 1)) fail("SDL_SetRenderVSync() error: %s", SDL_GetError());
-	if (!SDL_SetRenderLogicalPresentation(state.video.renderer, VIDEO_WIDTH, VIDEO_HEIGHT, SDL_LOGICAL_PRESENTATION_LETTERBOX)) fail("SDL_SetRenderLogicalPresentation() error: %s", SDL_GetError());
+//==[[ Library Interface ]]=============================================================================================
 
-	// init audio system
-	const SDL_AudioSpec want = { .format = SDL_AUDIO_S16, .freq = AUDIO_RATE, .channels = 1 };
-	if (!(state.audio.device = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL))) fail("SDL_OpenAudioDevice() error: %s", SDL_GetError());
-	if (!(state.audio.stream = SDL_CreateAudioStream(&want, NULL))) fail("SDL_CreateAudioStream() error: %s", SDL_GetError());
-	if (!SDL_BindAudioStream(state.audio.device, state.audio.stream)) fail("SDL_BindAudioStream() error: %s", SDL_GetError());
+_Static_assert(((int)XORX_VIDEO_COLS == (int)VIDEO_COLS) && ((int)XORX_VIDEO_ROWS == (int)VIDEO_ROWS), "xorx.h is out of sync");
+_Static_assert(((int)XORX_VIEW_COLS == (int)VIEW_COLS) && ((int)XORX_VIEW_ROWS == (int)VIEW_ROWS), "xorx.h is out of sync");
 
-	// init assets
-	state.video.texture = load_tiles("tiles.bmp");
-	for (int i = 0; i < AUDIO_SOUNDS; ++i) state.audio.sounds[i] = load_sound(strf("sound%02d.wav", i));
+// arguments of xorx_step_batch() shared by all job items
+typedef struct batch_t {
+	xorx_t **ctx; // instances to step
+	const uint8_t *buttons; // buttons per instance
+	xorx_reward_t *rewards; // rewards per instance (optional)
+	int observe; // kind of observation
+	uint8_t *observations; // observations per instance (optional)
+} batch_t;
 
-	// init game + time system
-	on_init();
-	state.time.last = SDL_GetTicks();
+// load the world shared by all instances
+bool xorx_init(const char *world) {
+	if (setjmp(state.core.error)) return false;
+	return load_world(world ? world : "world.bmp");
+}
 
-	return SDL_APP_CONTINUE;
+// create a new instance running a fresh game
+xorx_t *xorx_create(void) {
+	xorx_t *ctx = SDL_calloc(1, sizeof(xorx_t));
+	if (!ctx) return NULL;
+	ctx->players = 1;
+	on_init(ctx);
+	return ctx;
 }
 
-// callback to finalize the application
-void SDL_AppQuit(void *appstate, SDL_AppResult result) {
-	(void)appstate; (void)result;
-	// shutdown audio system
-	for (int i = 0; i < AUDIO_SOUNDS; ++i) if (state.audio.sounds[i].samples) SDL_free((void*)state.audio.sounds[i].samples);
-	if (state.audio.stream) SDL_DestroyAudioStream(state.audio.stream);
-	if (state.audio.device) SDL_CloseAudioDevice(state.audio.device);
+// destroy an instance
+void xorx_destroy(xorx_t *ctx) {
+	if (ctx) SDL_free(ctx->journal.undo);
+	SDL_free(ctx);
+}
 
-	// shutdown video system
+// stop the worker threads
+void xorx_quit(void) {
+	stop_pool();
+}
+
+// start a completely new game on the instance
+void xorx_reset(xorx_t *ctx) {
+	*ctx = (xorx_t){ .players = 1 };
+	on_init(ctx);
+}
+
+// advance the instance by a single tick
+void xorx_step(xorx_t *ctx, const uint8_t buttons) {
+	ctx->audio.playing = 0;
+	ctx->input.down[0] = buttons;
+	step(ctx);
+}
+
+// step a single instance of a batch and collect its rewards / observation
+static void step_batch(void *data, const int index) {
+	const batch_t *batch = data;
+	xorx_t *ctx = batch->ctx[index];
+	const int life = ctx->game.life, ammo = ctx->game.ammo;
+	const vec_t base = vbase(ctx->game.player[0]);
+	xorx_step(ctx, batch->buttons[index]);
+	if (batch->rewards) batch->rewards[index] = (xorx_reward_t){
+		.life = ctx->game.life - life,
+		.ammo = ctx->game.ammo - ammo,
+		.screen = !veq(base, vbase(ctx->game.player[0])),
+		.dead = ctx->game.dead,
+	};
+	if (!batch->observations) return;
+	if (batch->observe == XORX_OBSERVE_VIDEO) {
+		memcpy(batch->observations + (size_t)index * sizeof(ctx->video.data), ctx->video.data, sizeof(ctx->video.data));
+	} else if (batch->observe == XORX_OBSERVE_VIEW) {
+		uint8_t *dst = batch->observations + (size_t)index * VIEW_ROWS * VIEW_COLS;
+		for (int y = 0; y < VIEW_ROWS; ++y) {
+			for (int x = 0; x < VIEW_COLS; ++x) {
+				*dst++ = get(ctx, vadd(ctx->game.view, vec2(x, y))).tile;
+			}
+		}
+	}
+}
+
+// advance a batch of instances by a single tick in parallel
+void xorx_step_batch(xorx_t **ctx, const uint8_t *buttons, const int count, xorx_reward_t *rewards, const int observe, uint8_t *observations) {
+	batch_t batch = { .ctx = ctx, .buttons = buttons, .rewards = rewards, .observe = observe, .observations = observations };
+	parallel(step_batch, &batch, count);
+}
+
+// return the number of ticks the instance has run
+uint64_t xorx_tick(const xorx_t *ctx) {
+	return ctx->time.tick;
+}
+
+// return the screen content
+const uint8_t *xorx_video(const xorx_t *ctx) {
+	return &ctx->video.data[0][0];
+}
+
+// return the sound effects triggered by the last step
+uint32_t xorx_sounds(const xorx_t *ctx) {
+	return ctx->audio.playing;
+}
+
+
+#ifndef XORX_LIBRARY
+
+//==[[ Core Engine Routines ]]==========================================================================================
+
+// group of a tile in the indexed palette
+static int palette_group(const int tile) {
+	if ((tile == TILE_WATER_0) || (tile == TILE_WATER_1)) return 1;
+	if ((tile == TILE_LAVA_0) || (tile == TILE_LAVA_1)) return 2;
+	return 0;
+}
+
+// brightness of a color
+static int luma(const uint32_t color) {
+	return ((color >> 16) & 255) * 2 + ((color >> 8) & 255) * 5 + (color & 255);
+}
+
+// turn the tileset pixels into palette indices, water and lava get their own palette entries to cycle them
+static void index_tileset(void) {
+	int used[2][PALETTE_COLORS] = {0};
+	state.tileset.colors = 0;
+	for (int tile = 0; tile < 256; ++tile) {
+		const int group = palette_group(tile);
+		for (int y = 0; y < TILE_HEIGHT; ++y) {
+			for (int x = 0; x < TILE_WIDTH; ++x) {
+				const uint32_t color = state.tileset.pixels[tile][y][x];
+				int i = 0;
+				while ((i < state.tileset.colors) && (state.tileset.palette[i] != color)) ++i;
+				if (i == PALETTE_COLORS) { state.tileset.colors = 0; return; }
+				if (i == state.tileset.colors) state.tileset.palette[state.tileset.colors++] = color;
+				if (group) used[group - 1][i]++;
+				state.tileset.indices[tile][y][x] = (uint8_t)(group * PALETTE_COLORS + i);
+			}
+		}
+	}
+	// order the water / lava colors by brightness
+	for (int group = 0; group < 2; ++group) {
+		uint8_t *cycle = state.tileset.cycle[group];
+		int length = 0;
+		state.tileset.background[group] = 0;
+		for (int i = 0; i < state.tileset.colors; ++i) {
+			if (!used[group][i]) continue;
+			if (used[group][i] > used[group][state.tileset.background[group]]) state.tileset.background[group] = (uint8_t)i;
+			int j = length++;
+			for (; (j > 0) && (luma(state.tileset.palette[cycle[j - 1]]) > luma(state.tileset.palette[i])); --j) cycle[j] = cycle[j - 1];
+			cycle[j] = (uint8_t)i;
+		}
+		for (int j = 0; j < length; ++j) state.tileset.position[group][cycle[j]] = (uint8_t)j;
+		state.tileset.length[group] = length;
+	}
+}
+
+// the minimap shows every tile in its most used color and the player in the brightest color of the tileset
+static void color_minimap(void) {
+	state.minimap.marker = 0;
+	for (int tile = 0; tile < 256; ++tile) {
+		const uint32_t *pixels = &state.tileset.pixels[tile][0][0];
+		const uint8_t *indices = &state.tileset.indices[tile][0][0];
+		int mode = 0, most = 0;
+		for (int i = 0; i < TILE_WIDTH * TILE_HEIGHT; ++i) {
+			int count = 0;
+			for (int j = 0; j < TILE_WIDTH * TILE_HEIGHT; ++j) count += pixels[j] == pixels[i];
+			if (count > most) { most = count; mode = i; }
+			if (luma(pixels[i]) > luma(state.minimap.marker)) { state.minimap.marker = pixels[i]; state.minimap.marker_shade = indices[i]; }
+		}
+		state.minimap.colors[tile] = pixels[mode];
+		state.minimap.shades[tile] = indices[mode];
+	}
+	memset(state.xorx.video.minimap, 0xff, sizeof(state.xorx.video.minimap));
+}
+
+// load the tileset pixels for the software blitters, returns false on error
+static bool load_tileset(const char *name) {
+	SDL_Surface *surface = load_image(name);
+	if (!surface) return false;
+	SDL_Surface *pixels = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_XRGB8888);
+	SDL_DestroySurface(surface);
+	if (!pixels) return false;
+	if ((pixels->w != 16 * TILE_WIDTH) || (pixels->h != 16 * TILE_HEIGHT)) {
+		SDL_DestroySurface(pixels);
+		fail("Tiles(%s) has wrong size", name);
+	}
+	for (int tile = 0; tile < 256; ++tile) {
+		for (int y = 0; y < TILE_HEIGHT; ++y) {
+			const uint8_t *row = (const uint8_t*)pixels->pixels + ((tile / 16) * TILE_HEIGHT + y) * pixels->pitch;
+			memcpy(state.tileset.pixels[tile][y], row + (tile % 16) * TILE_WIDTH * sizeof(uint32_t), TILE_WIDTH * sizeof(uint32_t));
+		}
+	}
+	SDL_DestroySurface(pixels);
+	index_tileset();
+	color_minimap();
+	return true;
+}
+
+// blit rows x cols tiles (stride bytes apart per row) scaled up into XRGB8888 pixels (pitch in pixels)
+static void blit_tiles(const uint8_t *tiles, const int stride, const int cols, const int rows, uint32_t *pixels, const int pitch, const int scale) {
+	const int width = cols * TILE_WIDTH * scale;
+	for (int y = 0; y < rows * TILE_HEIGHT; ++y) {
+		uint32_t *dst = pixels + (size_t)y * scale * pitch;
+		const uint8_t *src = tiles + (y / TILE_HEIGHT) * stride;
+		if (scale == 1) {
+			// unscaled tile rows are plain copies the compiler turns into vector moves
+			for (int x = 0; x < cols; ++x) memcpy(dst + x * TILE_WIDTH, state.tileset.pixels[src[x]][y % TILE_HEIGHT], TILE_WIDTH * sizeof(uint32_t));
+			continue;
+		}
+		for (int x = 0, i = 0; x < cols; ++x) {
+			const uint32_t *row = state.tileset.pixels[src[x]][y % TILE_HEIGHT];
+			for (int j = 0; j < TILE_WIDTH; ++j) for (int k = 0; k < scale; ++k) dst[i++] = row[j];
+		}
+		// the other rows of a scaled pixel are just copies
+		for (int k = 1; k < scale; ++k) memcpy(dst + (size_t)k * pitch, dst, width * sizeof(uint32_t));
+	}
+}
+
+// background thread composing the queued screens and writing them to disk
+static int capture_thread(void *data) {
+	(void)data;
+	enum { WIDTH = VIDEO_WIDTH * RENDER_SCALE, HEIGHT = VIDEO_HEIGHT * RENDER_SCALE };
+	uint32_t *pixels = SDL_malloc(WIDTH * HEIGHT * sizeof(uint32_t));
+	SDL_Surface *surface = pixels ? SDL_CreateSurfaceFrom(WIDTH, HEIGHT, SDL_PIXELFORMAT_XRGB8888, pixels, WIDTH * sizeof(uint32_t)) : NULL;
+	SDL_LockMutex(state.capture.mutex);
+	for (;;) {
+		while (!state.capture.quit && !state.capture.count) SDL_WaitCondition(state.capture.wake, state.capture.mutex);
+		if (!state.capture.count) break;
+		// take the oldest screen out, the game can queue the next ones while we write it
+		const capture_t shot = state.capture.queue[state.capture.head];
+		state.capture.head = (state.capture.head + 1) % CAPTURE_QUEUE;
+		state.capture.count--;
+		// a reloaded tileset can't tear the screen while it is composed
+		if (surface) blit_tiles(&shot.data[0][0], VIDEO_COLS, VIDEO_COLS, VIDEO_ROWS, pixels, WIDTH, RENDER_SCALE);
+		SDL_UnlockMutex(state.capture.mutex);
+		if (surface) {
+			if (!SDL_SaveBMP(surface, shot.name)) SDL_Log("Can't write %s: %s", shot.name, SDL_GetError());
+		} else {
+			SDL_Log("Can't write %s: out of memory", shot.name);
+		}
+		SDL_LockMutex(state.capture.mutex);
+	}
+	SDL_UnlockMutex(state.capture.mutex);
+	if (surface) SDL_DestroySurface(surface);
+	SDL_free(pixels);
+	return 0;
+}
+
+// queue the current screen to be written to an image, returns false if the queue is full
+static bool capture(const char *name) {
+	if (!state.capture.thread) {
+		if (!(state.capture.mutex = SDL_CreateMutex())) fail("SDL_CreateMutex() error: %s", SDL_GetError());
+		if (!(state.capture.wake = SDL_CreateCondition())) fail("SDL_CreateCondition() error: %s", SDL_GetError());
+		if (!(state.capture.thread = SDL_CreateThread(capture_thread, "capture", NULL))) fail("SDL_CreateThread() error: %s", SDL_GetError());
+	}
+	SDL_LockMutex(state.capture.mutex);
+	const bool queued = state.capture.count < CAPTURE_QUEUE;
+	if (queued) {
+		capture_t *shot = &state.capture.queue[(state.capture.head + state.capture.count++) % CAPTURE_QUEUE];
+		memcpy(shot->data, state.xorx.video.data, sizeof(shot->data));
+		SDL_strlcpy(shot->name, name, sizeof(shot->name));
+		SDL_SignalCondition(state.capture.wake);
+	}
+	SDL_UnlockMutex(state.capture.mutex);
+	return queued;
+}
+
+// write the queued screens and stop the capture thread
+static void stop_capture(void) {
+	if (state.capture.thread) {
+		SDL_LockMutex(state.capture.mutex);
+		state.capture.quit = true;
+		SDL_SignalCondition(state.capture.wake);
+		SDL_UnlockMutex(state.capture.mutex);
+		SDL_WaitThread(state.capture.thread, NULL);
+	}
+	if (state.capture.mutex) SDL_DestroyMutex(state.capture.mutex);
+	if (state.capture.wake) SDL_DestroyCondition(state.capture.wake);
+	state.capture.thread = NULL; state.capture.mutex = NULL; state.capture.wake = NULL;
+	state.capture.quit = false;
+}
+
+// screenshot will take a screenshot
+static void screenshot(void) {
+	if (!capture("screenshot.bmp")) SDL_Log("Screenshot dropped, the capture queue is full");
+}
+
+// start / stop capturing the screen of every tick
+static void toggle_capture(void) {
+	state.capture.recording = !state.capture.recording;
+	if (state.capture.recording) {
+		state.capture.dropped = 0;
+		SDL_Log("Capturing to capture%06llu.bmp...", (unsigned long long)state.capture.frame);
+	} else {
+		SDL_Log("Capture stopped at frame %llu, %llu frames dropped", (unsigned long long)state.capture.frame, (unsigned long long)state.capture.dropped);
+	}
+}
+
+// capture the screen of the last tick while capturing
+static void capture_tick(void) {
+	if (!state.capture.recording) return;
+	if (!capture(strf("capture%06llu.bmp", (unsigned long long)state.capture.frame))) state.capture.dropped++;
+	state.capture.frame++;
+}
+
+_Static_assert(((int)XORX_SHM_COLS == (int)VIEW_COLS) && ((int)XORX_SHM_ROWS == (int)VIEW_ROWS), "xorx_shm.h is out of sync");
+
+// create the shared memory ring external tools read the observations from
+static void open_shm(const char *name) {
+#ifdef XORX_POSIX
+	const int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if (fd < 0) fail("shm_open(%s) error: %s", name, strerror(errno));
+	if (ftruncate(fd, sizeof(xorx_shm_t))) {
+		close(fd);
+		fail("ftruncate(%s) error: %s", name, strerror(errno));
+	}
+	xorx_shm_t *ring = mmap(NULL, sizeof(xorx_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ring == MAP_FAILED) fail("mmap(%s) error: %s", name, strerror(errno));
+	memset(ring, 0, sizeof(xorx_shm_t));
+	ring->magic = XORX_SHM_MAGIC;
+	ring->version = XORX_SHM_VERSION;
+	state.shm.name = name;
+	state.shm.ring = ring;
+#else
+	fail("Shared memory export (%s) is not supported on this platform", name);
+#endif
+}
+
+// remove the shared memory ring
+static void close_shm(void) {
+#ifdef XORX_POSIX
+	if (!state.shm.ring) return;
+	munmap(state.shm.ring, sizeof(xorx_shm_t));
+	shm_unlink(state.shm.name);
+	state.shm.ring = NULL;
+#endif
+}
+
+// publish the current tick into the next slot of the shared memory ring
+static void publish_shm(xorx_t *ctx) {
+	xorx_shm_t *ring = state.shm.ring;
+	if (!ring) return;
+	const uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed) + 1;
+	xorx_slot_t *slot = &ring->slots[head % XORX_SHM_SLOTS];
+	const uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+	atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	slot->frame.tick = ctx->time.tick;
+	slot->frame.life = ctx->game.life;
+	slot->frame.ammo = ctx->game.ammo;
+	slot->frame.flasks = ctx->game.flasks;
+	for (int y = 0; y < VIEW_ROWS; ++y) {
+		for (int x = 0; x < VIEW_COLS; ++x) {
+			slot->frame.tiles[y][x] = get(ctx, vadd(ctx->game.view, vec2(x, y))).tile;
+		}
+	}
+	atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+	atomic_store_explicit(&ring->head, head, memory_order_release);
+}
+
+// encode the changes between two screens as runs of [skip][count][count tiles], returns the encoded size
+static int encode_screen(const uint8_t *prev, const uint8_t *next, uint8_t *out) {
+	const int total = VIDEO_ROWS * VIDEO_COLS;
+	int size = 0;
+	for (int i = 0; i < total;) {
+		int skip = 0, count = 0;
+		while ((i + skip < total) && (skip < 255) && (prev[i + skip] == next[i + skip])) ++skip;
+		while ((i + skip + count < total) && (count < 255) && (prev[i + skip + count] != next[i + skip + count])) ++count;
+		if ((i + skip == total) && !count) break;
+		out[size++] = (uint8_t)skip;
+		out[size++] = (uint8_t)count;
+		memcpy(out + size, next + i + skip, count);
+		size += count;
+		i += skip + count;
+	}
+	return size;
+}
+
+// apply runs created by encode_screen() to a screen, returns false on malformed data
+static bool decode_screen(const uint8_t *in, const int size, uint8_t *screen) {
+	const int total = VIDEO_ROWS * VIDEO_COLS;
+	for (int i = 0, pos = 0; pos < size;) {
+		if (pos + 2 > size) return false;
+		const int count = in[pos + 1];
+		i += in[pos]; pos += 2;
+		if ((i + count > total) || (pos + count > size)) return false;
+		memcpy(screen + i, in + pos, count);
+		i += count; pos += count;
+	}
+	return true;
+}
+
+// build a frame message ('K' keyframe against a blank screen, 'D' delta against the last one), returns its size
+static int frame_message(const uint8_t type, const uint8_t *prev, const uint8_t *next, uint8_t *out) {
+	const int size = encode_screen(prev, next, out + 3);
+	out[0] = type; out[1] = size & 255; out[2] = size >> 8;
+	return size + 3;
+}
+
+// send a message to a spectator, slow or gone spectators are dropped
+static void send_spectator(const int index, const uint8_t *message, const int size) {
+#ifdef XORX_POSIX
+	if (write(state.spectate.clients[index], message, size) == size) return;
+	close(state.spectate.clients[index]);
+	state.spectate.clients[index] = state.spectate.clients[--state.spectate.count];
+#else
+	(void)index; (void)message; (void)size;
+#endif
+}
+
+// open a unix domain socket at path, either listening for spectators or connected to a broadcast
+static int open_socket(const char *path, const bool listening) {
+#ifdef XORX_POSIX
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	if (strlen(path) >= sizeof(addr.sun_path)) fail("Socket path too long: %s", path);
+	strcpy(addr.sun_path, path);
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) fail("socket() error: %s", strerror(errno));
+	if (listening) {
+		unlink(path);
+		if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(fd, SPECTATORS)) {
+			close(fd);
+			fail("Can't listen on %s: %s", path, strerror(errno));
+		}
+	} else if (connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+		close(fd);
+		fail("Can't connect to %s: %s", path, strerror(errno));
+	}
+	signal(SIGPIPE, SIG_IGN);
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+#else
+	(void)listening;
+	fail("Unix domain sockets (%s) are not supported on this platform", path);
+#endif
+}
+
+// accept new spectators and send them the changes of the current tick
+static void broadcast(xorx_t *ctx) {
+#ifdef XORX_POSIX
+	if (state.spectate.server < 0) return;
+	static const uint8_t blank[VIDEO_ROWS][VIDEO_COLS];
+	uint8_t keyframe[SPECTATE_MESSAGE];
+	const int keysize = frame_message('K', &blank[0][0], &ctx->video.data[0][0], keyframe);
+	// late joiners start with a keyframe
+	for (int fd; (state.spectate.count < SPECTATORS) && ((fd = accept(state.spectate.server, NULL, NULL)) >= 0);) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		state.spectate.clients[state.spectate.count++] = fd;
+		send_spectator(state.spectate.count - 1, keyframe, keysize);
+	}
+	// everybody else gets the delta or a periodic keyframe to resync
+	if (ctx->time.tick % SPECTATE_KEYFRAME == 0) {
+		for (int i = state.spectate.count - 1; i >= 0; --i) send_spectator(i, keyframe, keysize);
+	} else if (memcmp(state.spectate.sent, ctx->video.data, sizeof(state.spectate.sent))) {
+		uint8_t delta[SPECTATE_MESSAGE];
+		const int size = frame_message('D', &state.spectate.sent[0][0], &ctx->video.data[0][0], delta);
+		for (int i = state.spectate.count - 1; i >= 0; --i) send_spectator(i, delta, size);
+	}
+	memcpy(state.spectate.sent, ctx->video.data, sizeof(state.spectate.sent));
+#else
+	(void)ctx;
+#endif
+}
+
+// receive frames from the broadcast and apply them to the screen
+static void spectate(xorx_t *ctx) {
+#ifdef XORX_POSIX
+	const ssize_t length = read(state.spectate.viewer, state.spectate.buffer + state.spectate.length, sizeof(state.spectate.buffer) - state.spectate.length);
+	if ((length == 0) || ((length < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+		SDL_Log("Broadcast has ended");
+		state.core.running = false;
+		return;
+	}
+	if (length > 0) state.spectate.length += length;
+	int pos = 0;
+	while (pos + 3 <= state.spectate.length) {
+		const uint8_t *message = state.spectate.buffer + pos;
+		const int size = message[1] | (message[2] << 8);
+		if (size > SPECTATE_MESSAGE - 3) fail("Broadcast sent a malformed frame");
+		if (pos + 3 + size > state.spectate.length) break;
+		if (message[0] == 'K') cls(ctx);
+		if (!decode_screen(message + 3, size, &ctx->video.data[0][0])) fail("Broadcast sent a malformed frame");
+		pos += 3 + size;
+	}
+	memmove(state.spectate.buffer, state.spectate.buffer + pos, state.spectate.length - pos);
+	state.spectate.length -= pos;
+#else
+	(void)ctx;
+#endif
+}
+
+// stop broadcasting / spectating
+static void close_spectate(void) {
+#ifdef XORX_POSIX
+	for (int i = 0; i < state.spectate.count; ++i) close(state.spectate.clients[i]);
+	if (state.spectate.server >= 0) { close(state.spectate.server); unlink(state.spectate.path); }
+	if (state.spectate.viewer >= 0) close(state.spectate.viewer);
+	state.spectate.count = 0;
+	state.spectate.server = state.spectate.viewer = -1;
+#endif
+}
+
+// put a little endian number of size bytes, returns the position behind it
+static uint8_t *pack(uint8_t *data, const uint64_t value, const int size) {
+	for (int i = 0; i < size; ++i) *data++ = (uint8_t)(value >> (i * 8));
+	return data;
+}
+
+// take a little endian number of size bytes
+static uint64_t unpack(const uint8_t **data, const int size) {
+	uint64_t value = 0;
+	for (int i = 0; i < size; ++i) value |= (uint64_t)*(*data)++ << (i * 8);
+	return value;
+}
+
+// the scalars of the game in the same byte order on every machine
+static void pack_game(const struct game_t *game, uint8_t data[REPLAY_SCALARS]) {
+	data = pack(data, game->paused, 1); data = pack(data, game->dead, 1); data = pack(data, game->rand, 1); data = pack(data, game->tick, 1);
+	for (int i = 0; i < PLAYERS; ++i) { data = pack(data, (uint32_t)game->player[i].x, 4); data = pack(data, (uint32_t)game->player[i].y, 4); }
+	data = pack(data, (uint32_t)game->view.x, 4); data = pack(data, (uint32_t)game->view.y, 4);
+	data = pack(data, (uint32_t)game->life, 4); data = pack(data, (uint32_t)game->ammo, 4); data = pack(data, (uint32_t)game->flasks, 4);
+	data = pack(data, (uint32_t)game->keys, 4); data = pack(data, (uint32_t)game->gold, 4);
+	for (int i = 0; i < SCREENS / 64; ++i) data = pack(data, game->visited[i], 8);
+}
+static void unpack_game(struct game_t *game, const uint8_t data[REPLAY_SCALARS]) {
+	game->paused = unpack(&data, 1); game->dead = unpack(&data, 1); game->rand = unpack(&data, 1); game->tick = unpack(&data, 1);
+	for (int i = 0; i < PLAYERS; ++i) { game->player[i].x = (int32_t)unpack(&data, 4); game->player[i].y = (int32_t)unpack(&data, 4); }
+	game->view.x = (int32_t)unpack(&data, 4); game->view.y = (int32_t)unpack(&data, 4);
+	game->life = (int32_t)unpack(&data, 4); game->ammo = (int32_t)unpack(&data, 4); game->flasks = (int32_t)unpack(&data, 4);
+	game->keys = (int32_t)unpack(&data, 4); game->gold = (int32_t)unpack(&data, 4);
+	for (int i = 0; i < SCREENS / 64; ++i) game->visited[i] = unpack(&data, 8);
+}
+
+// hash the whole game state (FNV-1a), the same on every machine
+static uint64_t hash_game(const struct game_t *game) {
+	uint8_t scalars[REPLAY_SCALARS];
+	pack_game(game, scalars);
+	uint64_t hash = 0xcbf29ce484222325;
+	for (size_t i = 0; i < sizeof(scalars); ++i) hash = (hash ^ scalars[i]) * 0x100000001b3;
+	const uint8_t *cells = &game->cells[0][0].tile;
+	for (size_t i = 0; i < sizeof(game->cells); ++i) hash = (hash ^ cells[i]) * 0x100000001b3;
+	return hash;
+}
+
+// write a keyframe: the scalars, all cells differing from the pristine world and the hash of the whole state
+static bool write_keyframe(SDL_IOStream *io, xorx_t *ctx) {
+	uint32_t count = 0;
+	for (int y = 0; y < MAP_ROWS; ++y) {
+		if (!memcmp(ctx->game.cells[y], state.world.game.cells[y], sizeof(ctx->game.cells[y]))) continue;
+		for (int x = 0; x < MAP_COLS; ++x) count += memcmp(&ctx->game.cells[y][x], &state.world.game.cells[y][x], sizeof(cell_t)) != 0;
+	}
+	bool ok = SDL_WriteU8(io, 'K') && SDL_WriteU64LE(io, ctx->time.tick) && SDL_WriteU64LE(io, hash_game(&ctx->game));
+	for (int i = 0; i < PLAYERS; ++i) ok = ok && SDL_WriteU8(io, ctx->input.prev[i]);
+	uint8_t scalars[REPLAY_SCALARS];
+	pack_game(&ctx->game, scalars);
+	ok = ok && SDL_WriteU32LE(io, sizeof(scalars)) && (SDL_WriteIO(io, scalars, sizeof(scalars)) == sizeof(scalars));
+	ok = ok && SDL_WriteU32LE(io, count);
+	for (int y = 0; ok && (y < MAP_ROWS); ++y) {
+		if (!memcmp(ctx->game.cells[y], state.world.game.cells[y], sizeof(ctx->game.cells[y]))) continue;
+		for (int x = 0; ok && (x < MAP_COLS); ++x) {
+			const cell_t cell = ctx->game.cells[y][x];
+			if (!memcmp(&cell, &state.world.game.cells[y][x], sizeof(cell_t))) continue;
+			ok = SDL_WriteU32LE(io, y * MAP_COLS + x) && SDL_WriteU8(io, cell.tile) && SDL_WriteU8(io, cell.tick);
+		}
+	}
+	return ok;
+}
+
+// read a keyframe (behind its 'K') into an instance, returns false on malformed data
+static bool read_keyframe(SDL_IOStream *io, xorx_t *ctx, uint64_t *hash) {
+	uint32_t size, count;
+	if (!SDL_ReadU64LE(io, &ctx->time.tick) || !SDL_ReadU64LE(io, hash)) return false;
+	for (int i = 0; i < PLAYERS; ++i) {
+		uint8_t prev;
+		if (!SDL_ReadU8(io, &prev)) return false;
+		ctx->input.prev[i] = prev;
+	}
+	uint8_t scalars[REPLAY_SCALARS];
+	if (!SDL_ReadU32LE(io, &size) || (size != sizeof(scalars))) return false;
+	if ((SDL_ReadIO(io, scalars, size) != size) || !SDL_ReadU32LE(io, &count)) return false;
+	ctx->game = state.world.game;
+	unpack_game(&ctx->game, scalars);
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t index; cell_t cell;
+		if (!SDL_ReadU32LE(io, &index) || !SDL_ReadU8(io, &cell.tile) || !SDL_ReadU8(io, &cell.tick)) return false;
+		if (index >= MAP_ROWS * MAP_COLS) return false;
+		ctx->game.cells[index / MAP_COLS][index % MAP_COLS] = cell;
+	}
+	return true;
+}
+
+// start recording a replay of the game
+static void open_replay(const char *path) {
+	if (!(state.replay.file = SDL_IOFromFile(path, "wb"))) fail("Can't create replay %s: %s", path, SDL_GetError());
+	// the co-op game runs ahead on predicted input, its keyframes come from an instance with the final input only
+	if (state.xorx.players > 1) {
+		if (!(state.replay.ctx = SDL_calloc(1, sizeof(xorx_t)))) fail("Out of memory");
+		state.replay.ctx->players = state.xorx.players;
+		on_init(state.replay.ctx);
+	} else {
+		state.replay.ctx = &state.xorx;
+	}
+	SDL_IOStream *file = state.replay.file;
+	if (!SDL_WriteU32LE(file, REPLAY_MAGIC) || !SDL_WriteU32LE(file, REPLAY_VERSION) || !SDL_WriteU32LE(file, state.replay.ctx->players) ||
+		!SDL_WriteU64LE(file, hash_game(&state.world.game))) fail("Can't write replay %s: %s", path, SDL_GetError());
+}
+
+// write the buffered input followed by a keyframe of the recorded game, returns false on error
+static bool write_replay(void) {
+	SDL_IOStream *file = state.replay.file;
+	const int players = state.replay.ctx->players;
+	bool ok = true;
+	if (state.replay.count) {
+		ok = SDL_WriteU8(file, 'I') && SDL_WriteU32LE(file, state.replay.count);
+		for (int i = 0; ok && (i < state.replay.count); ++i) ok = SDL_WriteIO(file, state.replay.inputs[i], players) == (size_t)players;
+	}
+	state.replay.count = 0;
+	return ok && write_keyframe(file, state.replay.ctx);
+}
+
+// record the final input of the next tick before it gets simulated (co-op simulates it on its own instance for the keyframes)
+static void record_replay(const btn_t *inputs) {
+	xorx_t *ctx = state.replay.ctx;
+	if (!ctx) return;
+	if ((ctx->time.tick % REPLAY_KEYFRAME == 0) && !write_replay()) fail("Can't write replay: %s", SDL_GetError());
+	for (int i = 0; i < PLAYERS; ++i) state.replay.inputs[state.replay.count][i] = (uint8_t)inputs[i];
+	state.replay.count++;
+	if (ctx == &state.xorx) return;
+	memcpy(ctx->input.down, inputs, sizeof(ctx->input.down));
+	step(ctx);
+}
+
+// finish the replay with a last keyframe
+static void close_replay(void) {
+	if (!state.replay.file) return;
+	if (!write_replay()) SDL_Log("Can't write replay: %s", SDL_GetError());
+	SDL_CloseIO(state.replay.file);
+	if (state.replay.ctx != &state.xorx) SDL_free(state.replay.ctx);
+	state.replay.file = NULL;
+	state.replay.ctx = NULL;
+}
+
+// skip bytes of a replay
+static bool skip_replay(SDL_IOStream *io, const Sint64 size) {
+	return SDL_SeekIO(io, size, SDL_IO_SEEK_CUR) >= 0;
+}
+
+// split a replay into segments between two keyframes (partial keeps the ticks after the last one), returns false if the replay is malformed
+static bool scan_replay(const char *name, const uint8_t *data, const size_t size, const bool partial) {
+	SDL_IOStream *io = SDL_IOFromConstMem(data, size);
+	if (!io) return false;
+	uint32_t magic, version, players; uint64_t world;
+	bool ok = SDL_ReadU32LE(io, &magic) && SDL_ReadU32LE(io, &version) && SDL_ReadU32LE(io, &players) && SDL_ReadU64LE(io, &world) &&
+		(magic == REPLAY_MAGIC) && (version == REPLAY_VERSION) && (players >= 1) && (players <= PLAYERS) && (world == hash_game(&state.world.game));
+	segment_t *segment = NULL;
+	for (uint8_t type; ok && SDL_ReadU8(io, &type);) {
+		if (type == 'K') {
+			// a keyframe ends the last segment and starts a new one
+			const Sint64 offset = SDL_TellIO(io);
+			uint64_t tick, hash; uint32_t length, count;
+			ok = SDL_ReadU64LE(io, &tick) && SDL_ReadU64LE(io, &hash) && skip_replay(io, PLAYERS) && SDL_ReadU32LE(io, &length) &&
+				skip_replay(io, length) && SDL_ReadU32LE(io, &count) && skip_replay(io, (Sint64)count * 6);
+			if (!ok) break;
+			if (segment) {
+				if (segment->tick + segment->ticks != tick) { ok = false; break; }
+				segment->hash = hash;
+				segment->complete = true;
+			}
+			if (state.verify.count == state.verify.capacity) {
+				const int capacity = maxi(64, state.verify.capacity * 2);
+				segment_t *segments = SDL_realloc(state.verify.segments, capacity * sizeof(segment_t));
+				if (!segments) { ok = false; break; }
+				state.verify.segments = segments;
+				state.verify.capacity = capacity;
+			}
+			segment = &state.verify.segments[state.verify.count++];
+			*segment = (segment_t){ .name = name, .players = players, .keyframe = data + offset, .size = size - offset, .tick = tick };
+		} else if ((type == 'I') && segment && !segment->inputs) {
+			// input of every tick in the segment
+			uint32_t ticks;
+			ok = SDL_ReadU32LE(io, &ticks) && ((size_t)SDL_TellIO(io) + (size_t)ticks * players <= size);
+			if (!ok) break;
+			segment->inputs = data + SDL_TellIO(io);
+			segment->ticks = ticks;
+			ok = skip_replay(io, (Sint64)ticks * players);
+		} else {
+			ok = false;
+		}
+	}
+	ok = ok && ((size_t)SDL_TellIO(io) <= size);
+	SDL_CloseIO(io);
+	// the ticks after the last keyframe can't be verified
+	if (segment && !segment->complete && !partial) state.verify.count--;
+	return ok;
+}
+
+// simulate a single segment from its keyframe and compare the hash with the next keyframe
+static void verify_segment(void *data, const int index) {
+	segment_t *segment = &((segment_t*)data)[index];
+	xorx_t *ctx = SDL_calloc(1, sizeof(xorx_t));
+	SDL_IOStream *io = SDL_IOFromConstMem(segment->keyframe, segment->size);
+	uint64_t hash;
+	segment->ok = ctx && io && read_keyframe(io, ctx, &hash) && (hash_game(&ctx->game) == hash);
+	if (segment->ok) {
+		ctx->players = segment->players;
+		for (uint32_t t = 0; t < segment->ticks; ++t) {
+			for (int i = 0; i < segment->players; ++i) ctx->input.down[i] = segment->inputs[t * segment->players + i];
+			step(ctx);
+		}
+		segment->ok = hash_game(&ctx->game) == segment->hash;
+	}
+	if (io) SDL_CloseIO(io);
+	SDL_free(ctx);
+}
+
+// verify recorded replays, all their segments are simulated in parallel, returns false on any mismatch
+static bool verify_replays(char **names, const int count) {
+	const uint64_t start = SDL_GetTicks();
+	void **files = SDL_calloc(count, sizeof(void*));
+	if (!files) fail("Out of memory");
+	bool ok = true;
+	for (int i = 0; i < count; ++i) {
+		size_t size;
+		if (!(files[i] = SDL_LoadFile(names[i], &size))) { SDL_Log("%s: %s", names[i], SDL_GetError()); ok = false; continue; }
+		if (!scan_replay(names[i], files[i], size, false)) { SDL_Log("%s: malformed replay", names[i]); ok = false; }
+	}
+	parallel(verify_segment, state.verify.segments, state.verify.count);
+	uint64_t ticks = 0;
+	for (int i = 0; i < state.verify.count; ++i) {
+		const segment_t *segment = &state.verify.segments[i];
+		ticks += segment->ticks;
+		if (segment->ok) continue;
+		SDL_Log("%s: mismatch between tick %llu and %llu", segment->name, (unsigned long long)segment->tick, (unsigned long long)(segment->tick + segment->ticks));
+		ok = false;
+	}
+	const uint64_t time = maxi(1, SDL_GetTicks() - start);
+	SDL_Log("%s: %d replays, %d segments, %llu ticks verified in %.1f s (%.0f ticks/s)", ok ? "OK" : "FAILED", count, state.verify.count,
+		(unsigned long long)ticks, time / 1000.0, ticks * 1000.0 / time);
+	for (int i = 0; i < count; ++i) SDL_free(files[i]);
+	SDL_free(files);
+	SDL_free(state.verify.segments);
+	state.verify.segments = NULL;
+	state.verify.count = state.verify.capacity = 0;
+	return ok;
+}
+
+// convert XRGB8888 pixels into the Y, U and V planes of a Y4M frame (BT.601, 4:4:4)
+static void convert_yuv(const uint32_t *pixels, const int count, uint8_t *planes) {
+	uint8_t *y = planes, *u = planes + count, *v = planes + count * 2;
+	for (int i = 0; i < count; ++i) {
+		const int r = (pixels[i] >> 16) & 255, g = (pixels[i] >> 8) & 255, b = pixels[i] & 255;
+		y[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		u[i] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+		v[i] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+	}
+}
+
+// render a single segment of a replay, every tick becomes a frame
+static void render_segment(void *data, const int index) {
+	enum { WIDTH = VIDEO_WIDTH * RENDER_SCALE, HEIGHT = VIDEO_HEIGHT * RENDER_SCALE, FRAME = WIDTH * HEIGHT * 3 };
+	segment_t *segment = &((segment_t*)data)[index];
+	xorx_t *ctx = SDL_calloc(1, sizeof(xorx_t));
+	uint32_t *pixels = SDL_malloc(WIDTH * HEIGHT * sizeof(uint32_t));
+	uint8_t *planes = SDL_malloc(FRAME);
+	SDL_ClearError();
+	SDL_IOStream *io = SDL_IOFromConstMem(segment->keyframe, segment->size), *video = NULL;
+	uint64_t hash;
+	segment->ok = ctx && pixels && planes && io && read_keyframe(io, ctx, &hash);
+	if (!segment->ok && !SDL_GetError()[0]) SDL_SetError((ctx && pixels && planes) ? "malformed keyframe" : "out of memory");
+	if (segment->ok && state.render.y4m) {
+		// all frames have the same size, so every segment writes its part of the video on its own
+		const Sint64 offset = (Sint64)(state.render.header + (segment->tick - state.render.first) * (6 + FRAME));
+		segment->ok = (video = SDL_IOFromFile(state.render.path, "r+b")) && (SDL_SeekIO(video, offset, SDL_IO_SEEK_SET) == offset);
+	}
+	if (segment->ok) ctx->players = segment->players;
+	for (uint32_t t = 0; segment->ok && (t < segment->ticks); ++t) {
+		for (int i = 0; i < segment->players; ++i) ctx->input.down[i] = segment->inputs[t * segment->players + i];
+		step(ctx);
+		blit_tiles(&ctx->video.data[0][0], VIDEO_COLS, VIDEO_COLS, VIDEO_ROWS, pixels, WIDTH, RENDER_SCALE);
+		if (state.render.y4m) {
+			convert_yuv(pixels, WIDTH * HEIGHT, planes);
+			segment->ok = (SDL_WriteIO(video, "FRAME\n", 6) == 6) && (SDL_WriteIO(video, planes, FRAME) == FRAME);
+		} else {
+			const unsigned long long frame = segment->tick + t - state.render.first;
+			SDL_Surface *surface = SDL_CreateSurfaceFrom(WIDTH, HEIGHT, SDL_PIXELFORMAT_XRGB8888, pixels, WIDTH * sizeof(uint32_t));
+			segment->ok = surface && SDL_SaveBMP(surface, strf("%s%06llu.bmp", state.render.path, frame));
+			if (surface) SDL_DestroySurface(surface);
+		}
+	}
+	if (video && !SDL_CloseIO(video)) segment->ok = false;
+	if (!segment->ok) SDL_strlcpy(segment->error, SDL_GetError(), sizeof(segment->error));
+	if (io) SDL_CloseIO(io);
+	SDL_free(planes);
+	SDL_free(pixels);
+	SDL_free(ctx);
+}
+
+// render a recorded replay to a Y4M video (path ends with .y4m) or numbered BMP images, its segments are rendered in parallel, returns false on error
+static bool render_replay(const char *name, const char *path) {
+	const uint64_t start = SDL_GetTicks();
+	size_t size;
+	void *file = SDL_LoadFile(name, &size);
+	if (!file) { SDL_Log("%s: %s", name, SDL_GetError()); return false; }
+	bool ok = scan_replay(name, file, size, true) && state.verify.count;
+	if (!ok) SDL_Log("%s: malformed replay", name);
+	const size_t length = strlen(path);
+	state.render.path = path;
+	state.render.y4m = (length >= 4) && !strcmp(path + length - 4, ".y4m");
+	if (ok) state.render.first = state.verify.segments[0].tick;
+	if (ok && state.render.y4m) {
+		// the header goes first, the segments fill in the frames behind it
+		const char *header = strf("YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", VIDEO_WIDTH * RENDER_SCALE, VIDEO_HEIGHT * RENDER_SCALE, TICK_RATE);
+		SDL_IOStream *video = SDL_IOFromFile(path, "wb");
+		state.render.header = strlen(header);
+		ok = video && (SDL_WriteIO(video, header, state.render.header) == state.render.header);
+		if (video && !SDL_CloseIO(video)) ok = false;
+		if (!ok) SDL_Log("%s: %s", path, SDL_GetError());
+	}
+	uint64_t frames = 0;
+	if (ok) {
+		parallel(render_segment, state.verify.segments, state.verify.count);
+		for (int i = 0; i < state.verify.count; ++i) {
+			const segment_t *segment = &state.verify.segments[i];
+			frames += segment->ticks;
+			if (segment->ok) continue;
+			SDL_Log("%s: can't render tick %llu to %llu: %s", name, (unsigned long long)segment->tick, (unsigned long long)(segment->tick + segment->ticks), segment->error);
+			ok = false;
+		}
+	}
+	const uint64_t time = maxi(1, SDL_GetTicks() - start);
+	SDL_Log("%s: %llu frames of %s rendered in %.1f s (%.0f frames/s)", ok ? "OK" : "FAILED", (unsigned long long)frames, name,
+		time / 1000.0, frames * 1000.0 / time);
+	SDL_free(file);
+	SDL_free(state.verify.segments);
+	state.verify.segments = NULL;
+	state.verify.count = state.verify.capacity = 0;
+	return ok;
+}
+
+// run a replay to its end (from its last keyframe) on an instance, returns false on error
+static bool load_replay(const char *name, xorx_t *ctx) {
+	size_t size;
+	void *file = SDL_LoadFile(name, &size);
+	if (!file) { SDL_Log("%s: %s", name, SDL_GetError()); return false; }
+	bool ok = scan_replay(name, file, size, true) && state.verify.count;
+	if (ok) {
+		const segment_t *segment = &state.verify.segments[state.verify.count - 1];
+		SDL_IOStream *io = SDL_IOFromConstMem(segment->keyframe, segment->size);
+		uint64_t hash;
+		ok = io && read_keyframe(io, ctx, &hash);
+		if (io) SDL_CloseIO(io);
+		ctx->players = segment->players;
+		for (uint32_t t = 0; ok && (t < segment->ticks); ++t) {
+			for (int i = 0; i < segment->players; ++i) ctx->input.down[i] = segment->inputs[t * segment->players + i];
+			step(ctx);
+		}
+	}
+	if (!ok) SDL_Log("%s: malformed replay", name);
+	SDL_free(file);
+	SDL_free(state.verify.segments);
+	state.verify.segments = NULL;
+	state.verify.count = state.verify.capacity = 0;
+	return ok;
+}
+
+// blit a single row of world cells into the map image
+static void export_row(void *data, const int index) {
+	const map_t *map = data;
+	uint8_t tiles[MAP_COLS];
+	for (int x = 0; x < MAP_COLS; ++x) tiles[x] = map->game->cells[index][x].tile;
+	blit_tiles(tiles, MAP_COLS, MAP_COLS, 1, map->pixels + (size_t)index * TILE_HEIGHT * MAP_COLS * TILE_WIDTH, MAP_COLS * TILE_WIDTH, 1);
+}
+
+// export the whole world (or the end of a replay) to a single image, the rows are blitted in parallel, returns false on error
+static bool export_map(const char *path, const char *replay) {
+	enum { WIDTH = MAP_COLS * TILE_WIDTH, HEIGHT = MAP_ROWS * TILE_HEIGHT };
+	const uint64_t start = SDL_GetTicks();
+	xorx_t *ctx = SDL_calloc(1, sizeof(xorx_t));
+	uint32_t *pixels = SDL_malloc((size_t)WIDTH * HEIGHT * sizeof(uint32_t));
+	if (!ctx || !pixels) fail("Out of memory");
+	ctx->game = state.world.game;
+	bool ok = !replay || load_replay(replay, ctx);
+	if (ok) {
+		map_t map = { .game = &ctx->game, .pixels = pixels };
+		parallel(export_row, &map, MAP_ROWS);
+		SDL_Surface *surface = SDL_CreateSurfaceFrom(WIDTH, HEIGHT, SDL_PIXELFORMAT_XRGB8888, pixels, WIDTH * sizeof(uint32_t));
+		ok = surface && SDL_SaveBMP(surface, path);
+		if (surface) SDL_DestroySurface(surface);
+		if (!ok) SDL_Log("%s: %s", path, SDL_GetError());
+	}
+	if (ok) SDL_Log("OK: %dx%d map exported to %s in %.1f s", WIDTH, HEIGHT, path, (SDL_GetTicks() - start) / 1000.0);
+	SDL_free(pixels);
+	SDL_free(ctx);
+	return ok;
+}
+
+// next random number of a bot (xorshift, the game random numbers stay untouched)
+static uint32_t bot_rnd(bot_t *bot) {
+	bot->rand ^= bot->rand << 13;
+	bot->rand ^= bot->rand >> 17;
+	bot->rand ^= bot->rand << 5;
+	return bot->rand;
+}
+
+// return the button for a direction
+static btn_t dir_button(const dir_t dir) {
+	static const btn_t buttons[] = { BUTTON_NONE, BUTTON_UP, BUTTON_RIGHT, BUTTON_DOWN, BUTTON_LEFT };
+	return buttons[dir];
+}
+
+// returns true if a bot may walk onto the tile (ruins get shot, boulders pushed)
+static bool walkable(const uint8_t tile) {
+	switch (tile) {
+		case TILE_EMPTY: case TILE_LIFE: case TILE_AMMO: case TILE_FLASK: case TILE_GRASS_0: case TILE_GRASS_1:
+		case TILE_RUIN_0: case TILE_RUIN_1: case TILE_BOULDER:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// return the direction of a monster in line of sight
+static dir_t bot_aim(xorx_t *ctx, const vec_t src) {
+	for (dir_t dir = DIR_NORTH; dir <= DIR_WEST; ++dir) {
+		for (vec_t v = vmove(src, dir); visible(ctx, v); v = vmove(v, dir)) {
+			const uint8_t tile = get(ctx, v).tile;
+			if ((tile >= TILE_MONSTER_0) && (tile <= TILE_MONSTER_3)) return dir;
+			if (tile != TILE_EMPTY) break;
+		}
+	}
+	return DIR_NONE;
+}
+
+// return the first step of the shortest path to the neighbour screen the bot hasn't been on for the longest time
+static dir_t bot_path(bot_t *bot, xorx_t *ctx, const vec_t src) {
+	const vec_t base = vbase(src);
+	dir_t first[VIEW_ROWS][VIEW_COLS] = {}, best = DIR_NONE;
+	uint64_t oldest = UINT64_MAX;
+	vec_t queue[VIEW_ROWS * VIEW_COLS];
+	int head = 0, tail = 0;
+	queue[tail++] = src;
+	while (head < tail) {
+		const vec_t v = queue[head++];
+		for (dir_t dir = DIR_NORTH; dir <= DIR_WEST; ++dir) {
+			vec_t w = vmove(v, dir);
+			const uint8_t tile = get(ctx, w).tile;
+			if (tile == TILE_TELEPORT) {
+				// teleporters lead to the cell behind the next teleporter in line
+				do w = vmove(w, dir); while (inside(w) && (get(ctx, w).tile != TILE_TELEPORT));
+				w = vmove(w, dir);
+				if (veq(vbase(w), base)) continue;
+			} else if (!walkable(tile)) {
+				continue;
+			}
+			if (!inside(w)) continue;
+			const dir_t step = veq(v, src) ? dir : first[v.y - base.y][v.x - base.x];
+			if (!veq(vbase(w), base)) {
+				const uint64_t visited = bot->visited[w.y / VIEW_ROWS][w.x / VIEW_COLS];
+				if (!visited) return step;
+				if (visited < oldest) { oldest = visited; best = step; }
+				continue;
+			}
+			dir_t *seen = &first[w.y - base.y][w.x - base.x];
+			if (*seen || veq(w, src)) continue;
+			*seen = step;
+			queue[tail++] = w;
+		}
+	}
+	return best;
+}
+
+// let a bot choose the buttons of a player for the next tick
+static btn_t bot_input(bot_t *bot, xorx_t *ctx, const int id) {
+	const vec_t player = ctx->game.player[id];
+	// restart after dying (the button has to be released in between)
+	if (ctx->game.dead) return (ctx->time.tick % 2) ? BUTTON_A : BUTTON_NONE;
+	if (inside(player)) bot->visited[player.y / VIEW_ROWS][player.x / VIEW_COLS] = ctx->time.tick + 1;
+	bot->stuck = veq(player, bot->last) ? bot->stuck + 1 : 0;
+	bot->last = player;
+	// shoot monsters in line and walk towards unexplored screens
+	if (bot->explore && (bot->roam-- <= 0) && inside(player)) {
+		if (bot->stuck < TICK_RATE * 2) {
+			const dir_t aim = bot_aim(ctx, player);
+			if (aim) return BUTTON_A | dir_button(aim);
+			// now and then roam around, the shortest way isn't always the way out (boulders, teleporters)
+			const dir_t step = bot_path(bot, ctx, player);
+			if (step && (bot_rnd(bot) % (TICK_RATE * 4))) {
+				const uint8_t tile = get(ctx, vmove(player, step)).tile;
+				return dir_button(step) | (((tile == TILE_RUIN_0) || (tile == TILE_RUIN_1)) ? BUTTON_A : BUTTON_NONE);
+			}
+		}
+		bot->stuck = 0;
+		bot->roam = TICK_RATE + bot_rnd(bot) % (TICK_RATE * 4);
+	}
+	// mash random buttons (but never pause)
+	if (bot->ticks-- <= 0) {
+		bot->hold = bot_rnd(bot) & ~(BUTTON_X | BUTTON_Y);
+		bot->ticks = 1 + bot_rnd(bot) % TICK_RATE;
+	}
+	return bot->hold;
+}
+
+// check the invariants of a running game, returns a description of the first broken one
+static const char *check_game(xorx_t *ctx) {
+	const struct game_t *game = &ctx->game;
+	if (!inside(game->player[0])) return "player is outside of the world";
+	if ((game->life < 0) || (game->life > 999)) return "hitpoints out of range";
+	if ((game->ammo < 0) || (game->ammo > 999)) return "ammunition out of range";
+	if ((game->flasks < 0) || (game->flasks > 999)) return "flasks out of range";
+	if (game->dead != (game->life == 0)) return "dead without losing all hitpoints";
+	if ((game->view.x < 0) || (game->view.x > MAP_COLS - VIEW_COLS) || (game->view.y < 0) || (game->view.y > MAP_ROWS - VIEW_ROWS)) return "view outside of the world";
+	if (!game->dead) {
+		const uint8_t tile = get(ctx, game->player[0]).tile;
+		if (((tile < TILE_PLAYER_STAND) || (tile > TILE_PLAYER_DEFEND)) && ((tile < TILE_PSPAWN_0) || (tile > TILE_PSPAWN_3))) return "player position holds no player";
+	}
+	for (int y = 0; y < VIEW_ROWS; ++y) {
+		for (int x = 0; x < VIEW_COLS; ++x) {
+			const vec_t v = vadd(game->view, vec2(x, y));
+			const uint8_t tile = get(ctx, v).tile;
+			if (((tile < TILE_PLAYER_STAND) || (tile > TILE_PLAYER_DEFEND)) && ((tile < TILE_PSPAWN_0) || (tile > TILE_PSPAWN_3))) continue;
+			bool player = false;
+			for (int i = 0; i < ctx->players; ++i) player |= veq(game->player[i], v);
+			if (!player) return "stray player tile on the screen";
+		}
+	}
+	return NULL;
+}
+
+// report the run of the crashing thread
+static _Thread_local soak_t *soaking;
+static void soak_crash(const int sig) {
+#ifdef XORX_POSIX
+	// only write() and _exit() are safe in a signal handler, so the message is put together by hand
+	static char message[128];
+	int length = 0;
+	const char *parts[3] = { "Crash (signal ", ") in soak run with seed ", " at tick " };
+	const unsigned long long numbers[3] = { sig, soaking ? soaking->seed : 0, soaking ? soaking->done : 0 };
+	for (int i = 0; i < 3; ++i) {
+		for (const char *c = parts[i]; *c; ++c) message[length++] = *c;
+		char digits[20];
+		int count = 0;
+		for (unsigned long long n = numbers[i]; !count || n; n /= 10) digits[count++] = '0' + n % 10;
+		while (count) message[length++] = digits[--count];
+	}
+	message[length++] = '\n';
+	if (write(STDERR_FILENO, message, length)) {}
+	_exit(EXIT_FAILURE);
+#else
+	(void)sig;
+#endif
+}
+
+// keep the slowest ticks of a run, sorted from slowest to fastest
+static void note_slowest(soak_t *run, const uint64_t tick, const uint64_t time) {
+	int i = SOAK_SLOWEST;
+	while ((i > 0) && (run->slowest[i - 1].time < time)) --i;
+	if (i == SOAK_SLOWEST) return;
+	memmove(&run->slowest[i + 1], &run->slowest[i], (SOAK_SLOWEST - i - 1) * sizeof(run->slowest[0]));
+	run->slowest[i].tick = tick;
+	run->slowest[i].time = time;
+}
+
+// run a bot for many ticks, check the invariants every tick and the replay of it at the end
+static void soak_run(void *data, const int index) {
+	soak_t *run = &((soak_t*)data)[index];
+	xorx_t *ctx = SDL_calloc(1, sizeof(xorx_t)), *replay = SDL_calloc(1, sizeof(xorx_t));
+	bot_t *bot = SDL_calloc(1, sizeof(bot_t));
+	uint8_t *inputs = SDL_malloc(run->ticks);
+	uint64_t *hashes = SDL_malloc((run->ticks / REPLAY_KEYFRAME + 1) * sizeof(uint64_t));
+	soaking = run;
+	if (!ctx || !replay || !bot || !inputs || !hashes) { run->error = "out of memory"; goto done; }
+	// play
+	ctx->players = 1;
+	on_init(ctx);
+	*bot = (bot_t){ .rand = run->seed * 2654435761u | 1, .explore = run->seed % 2, .last = invalid_position };
+	const uint64_t start = SDL_GetPerformanceCounter();
+	for (run->done = 0; (run->done < run->ticks) && !run->error; ++run->done) {
+		if (run->done % REPLAY_KEYFRAME == 0) hashes[run->done / REPLAY_KEYFRAME] = hash_game(&ctx->game);
+		ctx->input.down[0] = inputs[run->done] = bot_input(bot, ctx, 0);
+		const uint64_t before = SDL_GetPerformanceCounter();
+		step(ctx);
+		note_slowest(run, run->done, SDL_GetPerformanceCounter() - before);
+		run->error = check_game(ctx);
+	}
+	run->seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+	for (int y = 0; y < MAP_ROWS / VIEW_ROWS; ++y) for (int x = 0; x < MAP_COLS / VIEW_COLS; ++x) run->screens += bot->visited[y][x] != 0;
+	// the replay of the recorded input has to end in exactly the same state
+	replay->players = 1;
+	on_init(replay);
+	run->diverged = UINT64_MAX;
+	for (uint64_t t = 0; t < run->done; ++t) {
+		if ((t % REPLAY_KEYFRAME == 0) && (hashes[t / REPLAY_KEYFRAME] != hash_game(&replay->game))) { run->diverged = t; break; }
+		replay->input.down[0] = inputs[t];
+		step(replay);
+	}
+	if ((run->diverged == UINT64_MAX) && (hash_game(&replay->game) != hash_game(&ctx->game))) run->diverged = run->done;
+	// keep the replay of failed runs for --verify
+	if (run->error || (run->diverged != UINT64_MAX)) {
+		SDL_IOStream *file = SDL_IOFromFile(run->replay, "wb");
+		bool ok = file && SDL_WriteU32LE(file, REPLAY_MAGIC) && SDL_WriteU32LE(file, REPLAY_VERSION) && SDL_WriteU32LE(file, 1) && SDL_WriteU64LE(file, hash_game(&state.world.game));
+		*replay = (xorx_t){ .players = 1 };
+		on_init(replay);
+		ok = ok && write_keyframe(file, replay) && SDL_WriteU8(file, 'I') && SDL_WriteU32LE(file, run->done) && (SDL_WriteIO(file, inputs, run->done) == run->done);
+		ok = ok && write_keyframe(file, ctx);
+		if (file) SDL_CloseIO(file);
+		if (!ok) SDL_strlcpy(run->replay, "", sizeof(run->replay));
+	}
+done:
+	soaking = NULL;
+	SDL_free(hashes); SDL_free(inputs); SDL_free(bot); SDL_free(replay); SDL_free(ctx);
+}
+
+// let bots play many games in parallel and report broken invariants, diverging replays and slow ticks
+static bool soak_test(const int seeds, const uint64_t ticks) {
+	soak_t *runs = SDL_calloc(seeds, sizeof(soak_t));
+	if (!runs) fail("Out of memory");
+	for (int i = 0; i < seeds; ++i) {
+		runs[i] = (soak_t){ .seed = i + 1, .ticks = ticks };
+		SDL_snprintf(runs[i].replay, sizeof(runs[i].replay), "soak-%d.rpl", i + 1);
+	}
+#ifdef XORX_POSIX
+	signal(SIGSEGV, soak_crash); signal(SIGBUS, soak_crash); signal(SIGFPE, soak_crash); signal(SIGILL, soak_crash);
+#endif
+	const uint64_t start = SDL_GetTicks();
+	parallel(soak_run, runs, seeds);
+	const double seconds = maxi(1, SDL_GetTicks() - start) / 1000.0;
+	// report every run
+	uint64_t total = 0; int failed = 0;
+	for (int i = 0; i < seeds; ++i) {
+		const soak_t *run = &runs[i];
+		total += run->done;
+		const bool ok = !run->error && (run->diverged == UINT64_MAX);
+		char problem[256] = "";
+		if (run->error) SDL_snprintf(problem, sizeof(problem), " - FAILED at tick %llu: %s", (unsigned long long)run->done - 1, run->error);
+		if (run->diverged != UINT64_MAX) SDL_strlcat(problem, strf(" - FAILED: replay diverged at tick %llu", (unsigned long long)run->diverged), sizeof(problem));
+		if (!ok && run->replay[0]) SDL_strlcat(problem, strf(" (replay saved to %s)", run->replay), sizeof(problem));
+		failed += !ok;
+		SDL_Log("seed %u (%s): %llu ticks, %.0f ticks/s, %d screens, slowest tick %.0f us%s",
+			run->seed, (run->seed % 2) ? "explore" : "random", (unsigned long long)run->done, run->seconds > 0 ? run->done / run->seconds : 0, run->screens,
+			run->slowest[0].time * 1e6 / SDL_GetPerformanceFrequency(), problem);
+	}
+	// report the slowest ticks of all runs
+	for (int n = 0; n < SOAK_SLOWEST; ++n) {
+		soak_t *worst = NULL; int slot = 0;
+		for (int i = 0; i < seeds; ++i) {
+			for (int j = 0; j < SOAK_SLOWEST; ++j) {
+				if (runs[i].slowest[j].time && (!worst || (runs[i].slowest[j].time > worst->slowest[slot].time))) { worst = &runs[i]; slot = j; }
+			}
+		}
+		if (!worst) break;
+		SDL_Log("slow tick: seed %u tick %llu took %.0f us", worst->seed, (unsigned long long)worst->slowest[slot].tick,
+			worst->slowest[slot].time * 1e6 / SDL_GetPerformanceFrequency());
+		worst->slowest[slot].time = 0;
+	}
+	SDL_Log("%s: %d runs, %d failed, %llu ticks in %.1f s (%.0f ticks/s)", failed ? "FAILED" : "OK", seeds, failed,
+		(unsigned long long)total, seconds, total / seconds);
+	SDL_free(runs);
+	return !failed;
+}
+
+// save everything besides the cells needed to roll back to the current tick
+static void save_snapshot(xorx_t *ctx, snapshot_t *snapshot) {
+	snapshot->tick = ctx->time.tick;
+	memcpy(snapshot->prev, ctx->input.prev, sizeof(snapshot->prev));
+	snapshot->journal = ctx->journal.count;
+	memcpy(snapshot->game, &ctx->game, sizeof(snapshot->game));
+}
+
+// roll the instance back to a snapshot by undoing all cell writes made since
+static void load_snapshot(xorx_t *ctx, const snapshot_t *snapshot) {
+	for (int i = ctx->journal.count - 1; i >= snapshot->journal; --i) {
+		const undo_t *undo = &ctx->journal.undo[i];
+		touch(ctx, undo->v, undo->cell.tile);
+		ctx->game.cells[undo->v.y][undo->v.x] = undo->cell;
+	}
+	ctx->journal.count = snapshot->journal;
+	ctx->time.tick = snapshot->tick;
+	memcpy(ctx->input.prev, snapshot->prev, sizeof(ctx->input.prev));
+	memcpy(&ctx->game, snapshot->game, sizeof(snapshot->game));
+}
+
+// drop the oldest journal entries, they will never be rolled back
+static void forget_journal(xorx_t *ctx, const int count) {
+	memmove(ctx->journal.undo, ctx->journal.undo + count, (ctx->journal.count - count) * sizeof(undo_t));
+	ctx->journal.count -= count;
+}
+
+// send all bytes through the socket / pipe transport
+static bool fd_send(transport_t *t, const uint8_t *data, const int size) {
+#ifdef XORX_POSIX
+	return write(t->out, data, size) == size;
+#else
+	(void)t; (void)data; (void)size;
+	return false;
+#endif
+}
+
+// receive the pending bytes from the socket / pipe transport
+static int fd_recv(transport_t *t, uint8_t *data, const int size) {
+#ifdef XORX_POSIX
+	const ssize_t length = read(t->in, data, size);
+	if (length > 0) return (int)length;
+	if ((length < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) return 0;
+#else
+	(void)t; (void)data; (void)size;
+#endif
+	return -1;
+}
+
+// close the socket / pipe transport
+static void fd_close(transport_t *t) {
+#ifdef XORX_POSIX
+	close(t->in);
+	if (t->out != t->in) close(t->out);
+#else
+	(void)t;
+#endif
+}
+
+// create a transport over non-blocking file descriptors (one socket or two pipes)
+static transport_t fd_transport(const int in, const int out) {
+	return (transport_t){ .send = fd_send, .recv = fd_recv, .close = fd_close, .in = in, .out = out };
+}
+
+// host a co-op game, the second player joins through the socket at path
+static void host_coop(const char *path) {
+	state.coop.server = open_socket(state.coop.path = path, true);
+	state.coop.local = 0;
+	state.xorx.players = PLAYERS;
+}
+
+// join a co-op game hosted at path as the second player
+static void join_coop(const char *path) {
+	const int fd = open_socket(path, false);
+	state.coop.transport = fd_transport(fd, fd);
+	state.coop.local = 1;
+	state.xorx.players = PLAYERS;
+}
+
+// accept the second player of a hosted game, returns false while still waiting
+static bool connect_coop(xorx_t *ctx) {
+	if (state.coop.transport.send) return true;
+#ifdef XORX_POSIX
+	const int fd = accept(state.coop.server, NULL, NULL);
+	if (fd >= 0) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		close(state.coop.server); unlink(state.coop.path);
+		state.coop.server = -1;
+		state.coop.transport = fd_transport(fd, fd);
+		return true;
+	}
+#endif
+	draw_game(ctx);
+	center(ctx, VIDEO_ROWS - 2, "WAITING FOR PLAYER 2");
+	return false;
+}
+
+// receive the remote input messages and note the first tick we predicted wrong, returns false if the remote side is gone
+static bool receive_coop(xorx_t *ctx) {
+	const int remote = !state.coop.local;
+	for (;;) {
+		const int length = state.coop.transport.recv(&state.coop.transport, state.coop.buffer + state.coop.length, sizeof(state.coop.buffer) - state.coop.length);
+		if (length < 0) return false;
+		if (length == 0) return true;
+		state.coop.length += length;
+		int pos = 0;
+		for (; pos + COOP_MESSAGE <= state.coop.length; pos += COOP_MESSAGE) {
+			const uint8_t *message = state.coop.buffer + pos;
+			const uint32_t tick = message[0] | (message[1] << 8) | (message[2] << 16) | ((uint32_t)message[3] << 24);
+			if (tick != (uint32_t)state.coop.remote) fail("The other player sent a malformed message");
+			btn_t *input = &state.coop.inputs[state.coop.remote % ROLLBACK_RING][remote];
+			if ((state.coop.remote < ctx->time.tick) && (*input != message[4]) && (state.coop.remote < state.coop.rollback)) state.coop.rollback = state.coop.remote;
+			*input = state.coop.last = message[4];
+			state.coop.remote++;
+		}
+		memmove(state.coop.buffer, state.coop.buffer + pos, state.coop.length - pos);
+		state.coop.length -= pos;
+	}
+}
+
+// simulate the next tick with the known or predicted input of every player
+static void simulate_coop(xorx_t *ctx) {
+	const uint64_t tick = ctx->time.tick;
+	btn_t *inputs = state.coop.inputs[tick % ROLLBACK_RING];
+	if (tick >= state.coop.remote) inputs[!state.coop.local] = state.coop.last;
+	save_snapshot(ctx, &state.coop.snapshots[tick % ROLLBACK_RING]);
+	memcpy(ctx->input.down, inputs, sizeof(ctx->input.down));
+	step(ctx);
+}
+
+// advance the co-op game by a single tick, returns false if the game has to wait for the remote side
+static bool update_coop(xorx_t *ctx) {
+	if (!connect_coop(ctx)) return false;
+	const uint64_t tick = ctx->time.tick;
+	const uint8_t message[COOP_MESSAGE] = { tick & 255, (tick >> 8) & 255, (tick >> 16) & 255, (tick >> 24) & 255, state.input.buttons };
+	if (!receive_coop(ctx)) {
+		SDL_Log("The other player has left");
+		state.core.running = false;
+		return false;
+	}
+	// the remote side is too far behind, wait for it
+	if (tick >= state.coop.remote + ROLLBACK_TICKS) return false;
+	// roll back to the first wrong prediction and simulate again (the sounds were played already)
+	if (state.coop.rollback < tick) {
+		const uint32_t playing = ctx->audio.playing;
+		load_snapshot(ctx, &state.coop.snapshots[state.coop.rollback % ROLLBACK_RING]);
+		while (ctx->time.tick < tick) simulate_coop(ctx);
+		ctx->audio.playing = playing;
+	}
+	state.coop.rollback = UINT64_MAX;
+	// send our input and simulate the new tick
+	state.coop.inputs[tick % ROLLBACK_RING][state.coop.local] = state.input.buttons;
+	if (!state.coop.transport.send(&state.coop.transport, message, sizeof(message))) {
+		SDL_Log("The other player has left");
+		state.core.running = false;
+		return false;
+	}
+	simulate_coop(ctx);
+	// record the ticks which have their final input now
+	while (state.replay.ctx && (state.replay.ctx->time.tick < state.coop.remote) && (state.replay.ctx->time.tick < ctx->time.tick)) {
+		record_replay(state.coop.inputs[state.replay.ctx->time.tick % ROLLBACK_RING]);
+	}
+	// ticks with confirmed input of both sides are final, forget how to undo them
+	if (state.coop.remote >= ctx->time.tick) {
+		forget_journal(ctx, ctx->journal.count);
+	} else {
+		const int count = state.coop.snapshots[state.coop.remote % ROLLBACK_RING].journal;
+		forget_journal(ctx, count);
+		for (uint64_t i = state.coop.remote; i < ctx->time.tick; ++i) state.coop.snapshots[i % ROLLBACK_RING].journal -= count;
+	}
+	return true;
+}
+
+// leave the co-op game
+static void close_coop(void) {
+#ifdef XORX_POSIX
+	if (state.coop.server >= 0) { close(state.coop.server); unlink(state.coop.path); }
+	state.coop.server = -1;
+#endif
+	if (state.coop.transport.close) state.coop.transport.close(&state.coop.transport);
+	state.coop.transport = (transport_t){};
+	SDL_free(state.xorx.journal.undo);
+	state.xorx.journal.undo = NULL;
+	state.xorx.journal.count = state.xorx.journal.capacity = 0;
+	state.xorx.journal.enabled = false;
+}
+
+// press will set/unset a button
+static void press(const btn_t mask, const bool down) {
+	if (down) state.input.buttons |= mask; else state.input.buttons &= ~mask;
+}
+
+// handle keyboard keys
+static void handle_keyboard(const SDL_Keycode key, const bool down) {
+	switch (key) {
+		case SDLK_ESCAPE: if (down) state.core.running = false; break;
+		case SDLK_F11: if (down) toggle_capture(); break;
+		case SDLK_F12: if (down) screenshot(); break;
+		case SDLK_M: if (down) state.minimap.overlay = !state.minimap.overlay; break;
+		case SDLK_W: case SDLK_8: case SDLK_KP_8: case SDLK_UP: press(BUTTON_UP, down); break;
+		case SDLK_S: case SDLK_2: case SDLK_KP_2: case SDLK_DOWN: press(BUTTON_DOWN, down); break;
+		case SDLK_A: case SDLK_4: case SDLK_KP_4: case SDLK_LEFT: press(BUTTON_LEFT, down); break;
+		case SDLK_D: case SDLK_6: case SDLK_KP_6: case SDLK_RIGHT: press(BUTTON_RIGHT, down); break;
+		case SDLK_I: case SDLK_RETURN: case SDLK_RETURN2: press(BUTTON_A, down); break;
+		case SDLK_O: case SDLK_SPACE: press(BUTTON_B, down); break;
+		case SDLK_K: press(BUTTON_X, down); break;
+		case SDLK_L: press(BUTTON_Y, down); break;
+	}
+}
+
+// handle gamepad buttons
+static void handle_gamepad(const int button, const bool down) {
+	switch (button) {
+		case SDL_GAMEPAD_BUTTON_DPAD_UP: press(BUTTON_UP, down); break;
+		case SDL_GAMEPAD_BUTTON_DPAD_DOWN: press(BUTTON_DOWN, down); break;
+		case SDL_GAMEPAD_BUTTON_DPAD_LEFT: press(BUTTON_LEFT, down); break;
+		case SDL_GAMEPAD_BUTTON_DPAD_RIGHT: press(BUTTON_RIGHT, down); break;
+		case SDL_GAMEPAD_BUTTON_NORTH: press(BUTTON_Y, down); break;
+		case SDL_GAMEPAD_BUTTON_SOUTH: press(BUTTON_A, down); break;
+		case SDL_GAMEPAD_BUTTON_WEST: press(BUTTON_X, down); break;
+		case SDL_GAMEPAD_BUTTON_EAST: press(BUTTON_Y, down); break;
+	}
+}
+
+// update timer and ticks
+static void update_ticks(void) {
+	const uint64_t now = SDL_GetTicks();
+	state.time.accu += now - state.time.last;
+	state.time.last = now;
+	for (; state.time.accu >= TICK_TIME; state.time.accu -= TICK_TIME) {
+		if (state.input.bot) state.input.buttons = bot_input(&state.bot, &state.xorx, state.coop.local);
+		if (state.xorx.players > 1) {
+			if (!update_coop(&state.xorx)) continue;
+		} else {
+			state.xorx.input.down[0] = state.input.buttons;
+			record_replay(state.xorx.input.down);
+			step(&state.xorx);
+		}
+		publish_shm(&state.xorx);
+		broadcast(&state.xorx);
+		capture_tick();
+	}
+}
+
+// update the audio stream
+static void update_audio(void) {
+	if (!state.audio.stream) { state.xorx.audio.playing = 0; return; }
+	// check the playing bit-mask and place sound effects into the mixer channels
+	if (state.xorx.audio.playing) {
+		for (int i = 0, j = 0; (i < AUDIO_SOUNDS) && (j < AUDIO_VOICES); ++i) {
+			if ((state.xorx.audio.playing & (1 << i)) == 0) continue;
+			const sound_t sound = state.audio.sounds[i];
+			if (!sound.samples) continue;
+			for (; j < AUDIO_VOICES; ++j) {
+				voice_t *voice = &state.audio.voices[j];
+				if (!voice->sound.samples) { *voice = (voice_t){ .sound = sound }; ++j; break; }
+			}
+		}
+		state.xorx.audio.playing = 0;
+	}
+	// check if we have to "render" more audio data
+	if (SDL_GetAudioStreamAvailable(state.audio.stream) < (int)(AUDIO_BUFFER * sizeof(int16_t))) {
+		int16_t buffer[AUDIO_BUFFER];
+		for (int i = 0; i < AUDIO_BUFFER; ++i) {
+			int total = 0;
+			for (int j = 0; j < AUDIO_VOICES; ++j) {
+				voice_t *voice = &state.audio.voices[j];
+				if (voice->sound.samples) {
+					if (voice->position < voice->sound.length) {
+						total += voice->sound.samples[voice->position++];
+					} else {
+						*voice = (voice_t){};
+					}
+				}
+			}
+			buffer[i] = (int16_t)clampi(total, -32768, 32767);
+		}
+		if (!SDL_PutAudioStreamData(state.audio.stream, buffer, sizeof(buffer))) fail("SDL_PutAudioStreamData() error: %s", SDL_GetError());
+	}
+}
+
+// draw a single tile as textured quad at a pixel position
+static void draw_tile(const int x, const int y, const unsigned int tile) {
+	const SDL_FRect src = { .x = (unsigned int)((tile % 16) * TILE_WIDTH), .y = (unsigned int)((tile / 16) * TILE_HEIGHT), .w = TILE_WIDTH, .h = TILE_HEIGHT };
+	const SDL_FRect dst = { .x = x, .y = y, .w = TILE_WIDTH, .h = TILE_HEIGHT };
+	SDL_RenderTexture(state.video.renderer, state.video.texture, &src, &dst);
+}
+
+// return the static layer of a screen, it gets (re-)drawn if it isn't cached or has changed (NULL without render targets)
+// all screens beyond the edges of the world share a single layer full of walls
+static layer_t *cached_layer(vec_t screen) {
+	if (!inside(screen)) screen = vec2(-VIEW_COLS, -VIEW_ROWS);
+	layer_t *layer = NULL, *oldest = &state.video.cache[0];
+	for (int i = 0; (i < LAYER_CACHE) && !layer; ++i) {
+		if (veq(state.video.cache[i].screen, screen) && state.video.cache[i].texture) layer = &state.video.cache[i];
+		else if (state.video.cache[i].used < oldest->used) oldest = &state.video.cache[i];
+	}
+	const int index = inside(screen) ? screen_index(screen) : 0;
+	uint64_t *changed = &state.xorx.video.changed[index / 64];
+	if (!layer || (inside(screen) && (*changed & (1ull << (index % 64))))) {
+		if (!layer) layer = oldest;
+		if (!layer->texture) {
+			layer->texture = SDL_CreateTexture(state.video.renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_TARGET, VIEW_COLS * TILE_WIDTH, VIEW_ROWS * TILE_HEIGHT);
+			if (!layer->texture) {
+				SDL_Log("SDL_CreateTexture() error: %s, drawing every tile", SDL_GetError());
+				state.video.layers = false;
+				return NULL;
+			}
+		}
+		if (!SDL_SetRenderTarget(state.video.renderer, layer->texture)) fail("SDL_SetRenderTarget() error: %s", SDL_GetError());
+		for (int y = 0; y < VIEW_ROWS; ++y) {
+			for (int x = 0; x < VIEW_COLS; ++x) {
+				layer->tiles[y][x] = static_tile(get(&state.xorx, vadd(screen, vec2(x, y))).tile);
+				draw_tile(x * TILE_WIDTH, y * TILE_HEIGHT, layer->tiles[y][x]);
+			}
+		}
+		if (!SDL_SetRenderTarget(state.video.renderer, NULL)) fail("SDL_SetRenderTarget() error: %s", SDL_GetError());
+		layer->screen = screen;
+		if (inside(screen)) *changed &= ~(1ull << (index % 64));
+	}
+	layer->used = ++state.video.frames;
+	return layer;
+}
+
+// position of the play screen in pixels for this frame, it scrolls smoothly to a neighbouring screen, returns true while scrolling
+static bool scroll_position(vec_t *position) {
+	const vec_t view = state.xorx.game.view, to = vec2(view.x * TILE_WIDTH, view.y * TILE_HEIGHT);
+	const uint64_t now = SDL_GetTicks();
+	if (!veq(view, state.video.view)) {
+		// teleports (and everything else but the neighbouring screens) cut
+		const vec_t d = vsub(view, state.video.view);
+		const bool neighbour = ((abs(d.x) == VIEW_COLS) && !d.y) || (!d.x && (abs(d.y) == VIEW_ROWS));
+		state.video.from = neighbour ? state.video.position : to;
+		state.video.view = view;
+		state.video.start = now;
+	}
+	// a spectator has no world cells, the pause map covers the play screen
+	const int elapsed = mini((int)(now - state.video.start), SCROLL_TIME);
+	if ((state.spectate.viewer >= 0) || state.xorx.game.paused || (elapsed == SCROLL_TIME)) state.video.from = to;
+	*position = vadd(state.video.from, vec2((to.x - state.video.from.x) * elapsed / SCROLL_TIME, (to.y - state.video.from.y) * elapsed / SCROLL_TIME));
+	state.video.position = *position;
+	const bool scrolling = !veq(*position, to);
+	// the frame after the scrolling composes the whole screen again
+	if (state.video.scrolling && !scrolling) state.video.stale = true;
+	return state.video.scrolling = scrolling;
+}
+
+// tiles of the display: the world around the screen of the player (the screen itself as drawn by the game) and the HUD stretched below
+static void compose_display(void) {
+	const int cols = state.video.cols, rows = state.video.rows;
+	const vec_t margin = vec2((cols - VIEW_COLS) / 2, (rows - VIEW_ROWS) / 2), origin = vsub(state.xorx.game.view, margin);
+	for (int y = 0; y < rows; ++y) {
+		uint8_t *row = state.video.shown[y];
+		if ((y >= margin.y) && (y < margin.y + VIEW_ROWS)) {
+			for (int x = 0; x < margin.x; ++x) row[x] = get(&state.xorx, vadd(origin, vec2(x, y))).tile;
+			memcpy(row + margin.x, state.xorx.video.data[y - margin.y], VIEW_COLS);
+			for (int x = margin.x + VIEW_COLS; x < cols; ++x) row[x] = get(&state.xorx, vadd(origin, vec2(x, y))).tile;
+		} else {
+			for (int x = 0; x < cols; ++x) row[x] = get(&state.xorx, vadd(origin, vec2(x, y))).tile;
+		}
+	}
+	// the ends of the HUD border stay at the edges
+	for (int y = 0; y < HUD_ROWS; ++y) {
+		const uint8_t *hud = state.xorx.video.data[VIEW_ROWS + y];
+		for (int x = 0; x < cols; ++x) state.video.shown[rows + y][x] = hud[(x == 0) ? 0 : (x == cols - 1) ? VIDEO_COLS - 1 : clampi(x - (cols - VIDEO_COLS) / 2, 1, VIDEO_COLS - 2)];
+	}
+}
+
+// top-left pixel of the view around the screen at a pixel position (negative beyond the edges of the world)
+static vec_t view_origin(const vec_t position) {
+	return vsub(position, vec2((state.video.cols - VIEW_COLS) / 2 * TILE_WIDTH, (state.video.rows - VIEW_ROWS) / 2 * TILE_HEIGHT));
+}
+
+// draw the static layers of the screens under the view at a pixel position, under receives the tiles they show from the cell at the top-left on
+static bool draw_layers(const vec_t origin, const vec_t cell, uint8_t under[DISPLAY_ROWS + 1][DISPLAY_COLS + 1]) {
+	const int cols = state.video.cols, rows = state.video.rows;
+	const vec_t base = vsub(cell, vec2(((cell.x % VIEW_COLS) + VIEW_COLS) % VIEW_COLS, ((cell.y % VIEW_ROWS) + VIEW_ROWS) % VIEW_ROWS));
+	bool ok = true;
+	for (int sy = base.y; ok && (sy * TILE_HEIGHT < origin.y + rows * TILE_HEIGHT); sy += VIEW_ROWS) {
+		for (int sx = base.x; ok && (sx * TILE_WIDTH < origin.x + cols * TILE_WIDTH); sx += VIEW_COLS) {
+			layer_t *layer = cached_layer(vec2(sx, sy));
+			if (!(ok = layer)) break;
+			const SDL_FRect dst = { .x = sx * TILE_WIDTH - origin.x, .y = sy * TILE_HEIGHT - origin.y, .w = VIEW_COLS * TILE_WIDTH, .h = VIEW_ROWS * TILE_HEIGHT };
+			SDL_RenderTexture(state.video.renderer, layer->texture, NULL, &dst);
+			for (int y = maxi(sy, cell.y); y < mini(sy + VIEW_ROWS, cell.y + rows + 1); ++y) {
+				for (int x = maxi(sx, cell.x); x < mini(sx + VIEW_COLS, cell.x + cols + 1); ++x) under[y - cell.y][x - cell.x] = layer->tiles[y - sy][x - sx];
+			}
+		}
+	}
+	return ok;
+}
+
+// stream a rectangle of the minimap into its texture (tiles backend)
+static void upload_minimap(const SDL_Rect rect) {
+	if (state.minimap.texture && !SDL_UpdateTexture(state.minimap.texture, &rect, &state.minimap.pixels[rect.y][rect.x], sizeof(state.minimap.pixels[0]))) fail("SDL_UpdateTexture() error: %s", SDL_GetError());
+}
+
+// draw a single minimap pixel: the most common static tile of the cells under it (nothing on unvisited screens) or the player
+static void create_minimap(void) {
+	state.minimap.texture = SDL_CreateTexture(state.video.renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_STREAMING, MINIMAP_COLS, MINIMAP_ROWS);
+	if (!state.minimap.texture) fail("SDL_CreateTexture() error: %s", SDL_GetError());
+	if (!SDL_SetTextureScaleMode(state.minimap.texture, SDL_SCALEMODE_NEAREST)) fail("SDL_SetTextureScaleMode() error: %s", SDL_GetError());
+	upload_minimap((SDL_Rect){ .x = 0, .y = 0, .w = MINIMAP_COLS, .h = MINIMAP_ROWS });
+}
+static void paint_minimap(const vec_t p) {
+	const xorx_t *ctx = &state.xorx;
+	const vec_t cell = vec2(p.x * (MAP_COLS / MINIMAP_COLS), p.y * (MAP_ROWS / MINIMAP_ROWS));
+	const int screen = screen_index(cell);
+	uint8_t tile = TILE_EMPTY;
+	if (ctx->game.visited[screen / 64] & (1ull << (screen % 64))) {
+		uint8_t count[256] = {0};
+		int most = 0;
+		for (int y = 0; y < MAP_ROWS / MINIMAP_ROWS; ++y) {
+			for (int x = 0; x < MAP_COLS / MINIMAP_COLS; ++x) {
+				const uint8_t t = static_tile(ctx->game.cells[cell.y + y][cell.x + x].tile);
+				if (++count[t] > most) { most = count[t]; tile = t; }
+			}
+		}
+	}
+	const bool marker = veq(p, state.minimap.position);
+	state.minimap.pixels[p.y][p.x] = marker ? state.minimap.marker : state.minimap.colors[tile];
+	state.minimap.indices[p.y][p.x] = marker ? state.minimap.marker_shade : state.minimap.shades[tile];
+}
+
+// bring the minimap up to date while it is shown, only the newly visited and changed screens are drawn again
+// returns true if it is shown, at receives its top-left display pixel (in the pause box or at the top-right of the view)
+static bool update_minimap(vec_t *at) {
+	xorx_t *ctx = &state.xorx;
+	const int cols = state.video.cols, rows = state.video.rows;
+	const bool paused = ctx->game.paused && !ctx->game.dead;
+	const bool shown = (state.spectate.viewer < 0) && (paused || state.minimap.overlay);
+	const vec_t margin = vec2((cols - VIEW_COLS) / 2, (rows - VIEW_ROWS) / 2);
+	*at = paused
+		? vec2((margin.x + (VIDEO_COLS - (MAP_COLS / VIEW_COLS / 2)) / 2) * TILE_WIDTH, (margin.y + (VIDEO_ROWS - (MAP_ROWS / VIEW_ROWS / 2)) / 2 - 1) * TILE_HEIGHT)
+		: vec2(cols * TILE_WIDTH - MINIMAP_COLS - TILE_WIDTH, TILE_HEIGHT);
+	// hiding or moving it leaves its pixels behind in the framebuffers
+	const bool moved = !state.minimap.shown || !veq(*at, state.minimap.at);
+	if (state.minimap.shown && (!shown || moved)) state.video.stale = true;
+	state.minimap.changed |= shown && moved;
+	state.minimap.shown = shown;
+	state.minimap.at = *at;
+	if (!shown) return false;
+	for (int i = 0; i < SCREENS / 64; ++i) {
+		const uint64_t dirty = ctx->video.minimap[i] | (ctx->game.visited[i] ^ state.minimap.visited[i]);
+		ctx->video.minimap[i] = 0;
+		state.minimap.visited[i] = ctx->game.visited[i];
+		for (int bit = 0; bit < 64; ++bit) {
+			if (!(dirty & (1ull << bit))) continue;
+			const int screen = i * 64 + bit;
+			const SDL_Rect rect = {
+				.x = (screen % (MAP_COLS / VIEW_COLS)) * MINIMAP_SCREEN_COLS, .y = (screen / (MAP_COLS / VIEW_COLS)) * MINIMAP_SCREEN_ROWS,
+				.w = MINIMAP_SCREEN_COLS, .h = MINIMAP_SCREEN_ROWS
+			};
+			for (int y = 0; y < rect.h; ++y) for (int x = 0; x < rect.w; ++x) paint_minimap(vec2(rect.x + x, rect.y + y));
+			upload_minimap(rect);
+			state.minimap.changed = true;
+		}
+	}
+	// the player marker moves from pixel to pixel
+	const vec_t player = ctx->game.player[0], position = vec2(player.x / (MAP_COLS / MINIMAP_COLS), player.y / (MAP_ROWS / MINIMAP_ROWS));
+	if (!veq(position, state.minimap.position)) {
+		const vec_t old = state.minimap.position;
+		state.minimap.position = position;
+		paint_minimap(old);
+		upload_minimap((SDL_Rect){ .x = old.x, .y = old.y, .w = 1, .h = 1 });
+		paint_minimap(position);
+		upload_minimap((SDL_Rect){ .x = position.x, .y = position.y, .w = 1, .h = 1 });
+		state.minimap.changed = true;
+	}
+	return true;
+}
+
+// copy the minimap into the software framebuffer (as pixels or palette indices) at a display pixel
+static void copy_minimap(const vec_t at, const bool indexed) {
+	for (int y = 0; y < MINIMAP_ROWS; ++y) {
+		if (indexed) memcpy(&state.video.indexed[at.y + y][at.x], state.minimap.indices[y], MINIMAP_COLS);
+		else memcpy(&state.video.pixels[at.y + y][at.x], state.minimap.pixels[y], sizeof(state.minimap.pixels[y]));
+	}
+}
+
+// draw every tile as a textured quad, except the ones already shown by the static layers
+static void draw_tiles(void) {
+	vec_t position;
+	const bool scrolling = scroll_position(&position);
+	const int cols = state.video.cols, rows = state.video.rows;
+	compose_display();
+	// the view, while scrolling it shows the world cells between two screens
+	const vec_t origin = view_origin(position), shift = vec2(origin.x & (TILE_WIDTH - 1), origin.y & (TILE_HEIGHT - 1));
+	const vec_t cell = vec2((origin.x - shift.x) / TILE_WIDTH, (origin.y - shift.y) / TILE_HEIGHT);
+	const SDL_Rect clip = { .x = 0, .y = 0, .w = cols * TILE_WIDTH, .h = rows * TILE_HEIGHT };
+	uint8_t under[DISPLAY_ROWS + 1][DISPLAY_COLS + 1];
+	SDL_SetRenderClipRect(state.video.renderer, &clip);
+	const bool layers = state.video.layers && draw_layers(origin, cell, under);
+	for (int y = 0; y < rows + (shift.y > 0); ++y) {
+		for (int x = 0; x < cols + (shift.x > 0); ++x) {
+			const uint8_t tile = scrolling ? get(&state.xorx, vadd(cell, vec2(x, y))).tile : state.video.shown[y][x];
+			if (layers && (under[y][x] == tile)) continue;
+			draw_tile(x * TILE_WIDTH - shift.x, y * TILE_HEIGHT - shift.y, tile);
+		}
+	}
+	vec_t at;
+	if (update_minimap(&at)) {
+		const SDL_FRect dst = { .x = at.x, .y = at.y, .w = MINIMAP_COLS, .h = MINIMAP_ROWS };
+		SDL_RenderTexture(state.video.renderer, state.minimap.texture, NULL, &dst);
+	}
+	state.minimap.changed = false;
+	SDL_SetRenderClipRect(state.video.renderer, NULL);
+	// the HUD
+	for (int y = rows; y < rows + HUD_ROWS; ++y) {
+		for (int x = 0; x < cols; ++x) draw_tile(x * TILE_WIDTH, y * TILE_HEIGHT, state.video.shown[y][x]);
+	}
+}
+
+// replicate every pixel of a row scale times (inlined with constant scales the compiler vectorizes the loops)
+static inline void widen(const uint32_t *src, uint32_t *dst, const int width, const int scale) {
+	for (int x = 0; x < width; ++x) for (int k = 0; k < scale; ++k) *dst++ = src[x];
+}
+
+// upscale a single framebuffer row (parallel job over the changed rows)
+static void upscale_row(void *data, const int index) {
+	(void)data;
+	const int y = state.video.top + index, scale = state.video.scale, width = state.video.cols * TILE_WIDTH, pitch = width * scale;
+	const uint32_t *src = state.video.pixels[y];
+	uint32_t *dst = state.video.upscaled + (size_t)y * scale * pitch;
+	switch (scale) {
+		case 2: widen(src, dst, width, 2); break;
+		case 3: widen(src, dst, width, 3); break;
+		case 4: widen(src, dst, width, 4); break;
+		case 5: widen(src, dst, width, 5); break;
+		case 6: widen(src, dst, width, 6); break;
+		case 7: widen(src, dst, width, 7); break;
+		default: widen(src, dst, width, 8); break;
+	}
+	for (int k = 1; k < scale; ++k) memcpy(dst + (size_t)k * pitch, dst, pitch * sizeof(uint32_t));
+}
+
+// factor which shrinks an image of width x height to fit into w x h
+static float shrink_scale(const int w, const int h, const int width, const int height) {
+	const float x = (float)w / width, y = (float)h / height;
+	return x < y ? x : y;
+}
+
+// stream the changed framebuffer rows into its texture, upscaled by the largest integer factor fitting the window, and draw it centered
+static void present_framebuffer(int top, int bottom) {
+	const int width = state.video.cols * TILE_WIDTH, height = (state.video.rows + HUD_ROWS) * TILE_HEIGHT;
+	int w, h;
+	if (!SDL_GetRenderOutputSize(state.video.renderer, &w, &h)) fail("SDL_GetRenderOutputSize() error: %s", SDL_GetError());
+	const int scale = clampi(mini(w / width, h / height), 1, UPSCALE_MAX);
+	if (scale != state.video.scale) {
+		// the window was resized, start over with a texture of the new size
+		if (state.video.frame) SDL_DestroyTexture(state.video.frame);
+		SDL_free(state.video.upscaled);
+		state.video.upscaled = NULL;
+		state.video.frame = SDL_CreateTexture(state.video.renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_STREAMING, width * scale, height * scale);
+		if (!state.video.frame) fail("SDL_CreateTexture() error: %s", SDL_GetError());
+		if (!SDL_SetTextureScaleMode(state.video.frame, SDL_SCALEMODE_NEAREST)) fail("SDL_SetTextureScaleMode() error: %s", SDL_GetError());
+		if ((scale > 1) && !(state.video.upscaled = SDL_malloc((size_t)width * height * scale * scale * sizeof(uint32_t)))) fail("Out of memory");
+		state.video.scale = scale;
+		top = 0; bottom = height - 1;
+	}
+	if (top <= bottom) {
+		const SDL_Rect rect = { .x = 0, .y = top * scale, .w = width * scale, .h = (bottom - top + 1) * scale };
+		const uint32_t *pixels = state.video.pixels[top];
+		int pitch = sizeof(state.video.pixels[0]);
+		if (scale > 1) {
+			// large windows get upscaled in horizontal bands on all cores
+			state.video.top = top;
+			parallel(upscale_row, NULL, bottom - top + 1);
+			pixels = state.video.upscaled + (size_t)rect.y * rect.w;
+			pitch = rect.w * sizeof(uint32_t);
+		}
+		if (!SDL_UpdateTexture(state.video.frame, &rect, pixels, pitch)) fail("SDL_UpdateTexture() error: %s", SDL_GetError());
+	}
+	// windows smaller than the image get it shrunk to fit, letterboxed like the other backends
+	const float fit = ((w < width) || (h < height)) ? shrink_scale(w, h, width, height) : scale;
+	const SDL_FRect dst = { .x = (w - width * fit) / 2, .y = (h - height * fit) / 2, .w = width * fit, .h = height * fit };
+	if (!SDL_RenderTexture(state.video.renderer, state.video.frame, NULL, &dst)) fail("SDL_RenderTexture() error: %s", SDL_GetError());
+}
+
+// compose the view between two screens straight from the world cells (as pixels or palette indices)
+static void compose_scrolled(const vec_t position, const bool indexed) {
+	const int cols = state.video.cols;
+	const vec_t origin = view_origin(position);
+	const int shift = origin.x & (TILE_WIDTH - 1), cx = (origin.x - shift) / TILE_WIDTH;
+	for (int y = 0; y < state.video.rows * TILE_HEIGHT; ++y) {
+		const int py = origin.y + y, ty = py & (TILE_HEIGHT - 1), cy = (py - ty) / TILE_HEIGHT;
+		uint32_t pixels[(DISPLAY_COLS + 1) * TILE_WIDTH];
+		uint8_t indices[(DISPLAY_COLS + 1) * TILE_WIDTH];
+		for (int x = 0; x <= cols; ++x) {
+			const uint8_t tile = get(&state.xorx, vec2(cx + x, cy)).tile;
+			if (indexed) memcpy(indices + x * TILE_WIDTH, state.tileset.indices[tile][ty], TILE_WIDTH);
+			else memcpy(pixels + x * TILE_WIDTH, state.tileset.pixels[tile][ty], TILE_WIDTH * sizeof(uint32_t));
+		}
+		if (indexed) memcpy(state.video.indexed[y], indices + shift, cols * TILE_WIDTH);
+		else memcpy(state.video.pixels[y], pixels + shift, cols * TILE_WIDTH * sizeof(uint32_t));
+	}
+}
+
+// compose the changed tile rows in the software framebuffer and present them
+static void draw_framebuffer(void) {
+	vec_t position;
+	const bool scrolling = scroll_position(&position);
+	const int cols = state.video.cols, rows = state.video.rows;
+	compose_display();
+	vec_t at;
+	const bool minimap = update_minimap(&at);
+	int top = DISPLAY_ROWS, bottom = -1;
+	if (scrolling) {
+		compose_scrolled(position, false);
+		top = 0; bottom = rows - 1;
+	}
+	for (int y = scrolling ? rows : 0; y < rows + HUD_ROWS; ++y) {
+		if (!state.video.stale && !memcmp(state.video.drawn[y], state.video.shown[y], cols)) continue;
+		blit_tiles(state.video.shown[y], DISPLAY_COLS, cols, 1, state.video.pixels[y * TILE_HEIGHT], DISPLAY_COLS * TILE_WIDTH, 1);
+		memcpy(state.video.drawn[y], state.video.shown[y], cols);
+		top = mini(top, y); bottom = y;
+	}
+	// the minimap goes on top again when the rows under it were composed
+	if (minimap && (state.minimap.changed || ((top <= (at.y + MINIMAP_ROWS - 1) / TILE_HEIGHT) && (bottom >= at.y / TILE_HEIGHT)))) {
+		copy_minimap(at, false);
+		top = mini(top, at.y / TILE_HEIGHT); bottom = maxi(bottom, (at.y + MINIMAP_ROWS - 1) / TILE_HEIGHT);
+	}
+	state.minimap.changed = false;
+	state.video.stale = false;
+	present_framebuffer(top * TILE_HEIGHT, (bottom + 1) * TILE_HEIGHT - 1);
+}
+
+// expand the indexed palette for a frame: water / lava colors take turns every few ticks, fade (0-256) darkens everything
+static void cycle_palette(uint32_t *lut, const uint64_t tick, const int fade) {
+	for (int group = 0; group < 3; ++group) {
+		for (int i = 0; i < state.tileset.colors; ++i) {
+			uint32_t color = state.tileset.palette[i];
+			if (group && (i != state.tileset.background[group - 1])) {
+				const int length = state.tileset.length[group - 1];
+				color = state.tileset.palette[state.tileset.cycle[group - 1][(state.tileset.position[group - 1][i] + tick / PALETTE_CYCLE) % length]];
+			}
+			const uint32_t r = ((color >> 16) & 255) * fade / 256, g = ((color >> 8) & 255) * fade / 256, b = (color & 255) * fade / 256;
+			lut[group * PALETTE_COLORS + i] = (r << 16) | (g << 8) | b;
+		}
+	}
+}
+
+// compose the changed tile rows as palette indices, expand them with the palette of this frame and present them
+static void draw_indexed(void) {
+	vec_t position;
+	const bool scrolling = scroll_position(&position);
+	const int cols = state.video.cols, rows = state.video.rows, width = cols * TILE_WIDTH, height = (rows + HUD_ROWS) * TILE_HEIGHT;
+	compose_display();
+	vec_t at;
+	const bool minimap = update_minimap(&at);
+	bool changed = state.video.stale || scrolling;
+	if (scrolling) compose_scrolled(position, true);
+	for (int y = scrolling ? rows : 0; y < rows + HUD_ROWS; ++y) {
+		if (!state.video.stale && !memcmp(state.video.drawn[y], state.video.shown[y], cols)) continue;
+		for (int i = 0; i < TILE_HEIGHT; ++i) {
+			uint8_t *dst = state.video.indexed[y * TILE_HEIGHT + i];
+			for (int x = 0; x < cols; ++x) memcpy(dst + x * TILE_WIDTH, state.tileset.indices[state.video.shown[y][x]][i], TILE_WIDTH);
+		}
+		memcpy(state.video.drawn[y], state.video.shown[y], cols);
+		changed = true;
+	}
+	if (minimap && (changed || state.minimap.changed)) {
+		copy_minimap(at, true);
+		changed = true;
+	}
+	state.minimap.changed = false;
+	state.video.stale = false;
+	// the death fades the play screen, the HUD stays readable
+	uint32_t lut[2][3 * PALETTE_COLORS];
+	const uint64_t tick = state.xorx.time.tick;
+	if (!state.xorx.game.dead) state.video.alive = tick;
+	const int dying = (tick - state.video.alive < DEATH_FADE) ? (int)(tick - state.video.alive) : DEATH_FADE;
+	cycle_palette(lut[0], tick, 256 - dying * 160 / DEATH_FADE);
+	cycle_palette(lut[1], tick, 256);
+	if (memcmp(lut, state.video.lut, sizeof(lut))) {
+		memcpy(state.video.lut, lut, sizeof(lut));
+		changed = true;
+	}
+	// expand the whole screen at once, a palette change touches every pixel anyway
+	if (changed) {
+		for (int y = 0; y < height; ++y) {
+			const uint32_t *row = state.video.lut[y >= rows * TILE_HEIGHT];
+			for (int x = 0; x < width; ++x) state.video.pixels[y][x] = row[state.video.indexed[y][x]];
+		}
+	}
+	present_framebuffer(changed ? 0 : height, height - 1);
+}
+
+// draw the changed tiles scaled into the window surface and push only their rectangles to the window
+static void draw_surface(void) {
+	SDL_Surface *surface = SDL_GetWindowSurface(state.video.window);
+	if (!surface) fail("SDL_GetWindowSurface() error: %s", SDL_GetError());
+	const int cols = state.video.cols, rows = state.video.rows + HUD_ROWS;
+	const int width = cols * TILE_WIDTH, height = rows * TILE_HEIGHT;
+	// windows smaller than the view get it shrunk to fit, the tiles end up with slightly different sizes then
+	const float scale = ((surface->w < width) || (surface->h < height)) ? shrink_scale(surface->w, surface->h, width, height) : mini(surface->w / width, surface->h / height);
+	const int x0 = (surface->w - (int)(width * scale)) / 2, y0 = (surface->h - (int)(height * scale)) / 2;
+	compose_display();
+	if (!veq(state.video.size, vec2(surface->w, surface->h))) {
+		// a new surface (the window was resized), fill the letterbox and draw everything
+		const uint32_t color = state.tileset.pixels[0][0][0];
+		if (!SDL_FillSurfaceRect(surface, NULL, SDL_MapSurfaceRGB(surface, color >> 16, color >> 8, color))) fail("SDL_FillSurfaceRect() error: %s", SDL_GetError());
+		state.video.size = vec2(surface->w, surface->h);
+		state.video.stale = true;
+	}
+	static SDL_Rect rects[DISPLAY_ROWS * DISPLAY_COLS]; // too large for the stack
+	int count = 0;
+	for (int y = 0; y < rows; ++y) {
+		for (int x = 0; x < cols; ++x) {
+			const uint8_t tile = state.video.shown[y][x];
+			if (!state.video.stale && (state.video.drawn[y][x] == tile)) continue;
+			state.video.drawn[y][x] = tile;
+			const SDL_Rect src = { .x = 0, .y = tile * TILE_HEIGHT, .w = TILE_WIDTH, .h = TILE_HEIGHT };
+			const int left = x * TILE_WIDTH * scale, top = y * TILE_HEIGHT * scale;
+			const SDL_Rect dst = { .x = x0 + left, .y = y0 + top, .w = (int)((x + 1) * TILE_WIDTH * scale) - left, .h = (int)((y + 1) * TILE_HEIGHT * scale) - top };
+			if (!dst.w || !dst.h) continue; // tiny windows shrink some tiles away
+			if (!SDL_BlitSurfaceScaled(state.video.strip, &src, surface, &dst, SDL_SCALEMODE_NEAREST)) fail("SDL_BlitSurfaceScaled() error: %s", SDL_GetError());
+			// neighbouring tiles in a row share a rectangle
+			SDL_Rect *last = count ? &rects[count - 1] : NULL;
+			if (last && (last->y == dst.y) && (last->x + last->w == dst.x)) last->w += dst.w; else rects[count++] = dst;
+		}
+	}
+	if (state.video.stale) {
+		rects[0] = (SDL_Rect){ .x = 0, .y = 0, .w = surface->w, .h = surface->h };
+		count = 1;
+		state.video.stale = false;
+	}
+	if (count && !SDL_UpdateWindowSurfaceRects(state.video.window, rects, count)) fail("SDL_UpdateWindowSurfaceRects() error: %s", SDL_GetError());
+}
+
+// nearest of the 16 ANSI terminal colors (VGA values)
+static uint8_t ansi_color(const uint32_t color) {
+	static const uint32_t ansi[16] = {
+		0x000000, 0xaa0000, 0x00aa00, 0xaa5500, 0x0000aa, 0xaa00aa, 0x00aaaa, 0xaaaaaa,
+		0x555555, 0xff5555, 0x55ff55, 0xffff55, 0x5555ff, 0xff55ff, 0x55ffff, 0xffffff,
+	};
+	int best = 0, distance = INT32_MAX;
+	for (int i = 0; i < 16; ++i) {
+		const int r = (int)((color >> 16) & 255) - (int)((ansi[i] >> 16) & 255);
+		const int g = (int)((color >> 8) & 255) - (int)((ansi[i] >> 8) & 255);
+		const int b = (int)(color & 255) - (int)(ansi[i] & 255);
+		if (r * r + g * g + b * b < distance) { distance = r * r + g * g + b * b; best = i; }
+	}
+	return (uint8_t)best;
+}
+
+// most used color in a quarter of a tile
+static uint32_t quarter_color(const int tile, const int qx, const int qy) {
+	uint32_t best = 0;
+	for (int i = 0, most = 0; i < (TILE_WIDTH / 2) * (TILE_HEIGHT / 2); ++i) {
+		const uint32_t color = state.tileset.pixels[tile][qy * TILE_HEIGHT / 2 + i / (TILE_WIDTH / 2)][qx * TILE_WIDTH / 2 + i % (TILE_WIDTH / 2)];
+		int count = 0;
+		for (int j = 0; j < (TILE_WIDTH / 2) * (TILE_HEIGHT / 2); ++j) count += state.tileset.pixels[tile][qy * TILE_HEIGHT / 2 + j / (TILE_WIDTH / 2)][qx * TILE_WIDTH / 2 + j % (TILE_WIDTH / 2)] == color;
+		if (count > most) { most = count; best = color; }
+	}
+	return best;
+}
+
+// build the glyph table: the font tiles stay characters, every other tile becomes 2 x 2 colored half blocks
+static void build_glyphs(void) {
+	const uint32_t background = state.tileset.pixels[0][0][0];
+	for (int tile = 0; tile < 256; ++tile) {
+		glyph_t *glyph = &state.terminal.glyphs[tile];
+		if ((tile > ' ') && (tile < 127)) {
+			// the font is drawn in a single color on the background
+			uint32_t color = background;
+			for (int i = 0; (i < TILE_WIDTH * TILE_HEIGHT) && (color == background); ++i) color = state.tileset.pixels[tile][i / TILE_WIDTH][i % TILE_WIDTH];
+			*glyph = (glyph_t){ .text = { { (char)tile }, " " }, .fg = { ansi_color(color), ansi_color(color) }, .bg = { ansi_color(background), ansi_color(background) } };
+			continue;
+		}
+		for (int half = 0; half < 2; ++half) {
+			glyph->fg[half] = ansi_color(quarter_color(tile, half, 0));
+			glyph->bg[half] = ansi_color(quarter_color(tile, half, 1));
+			// upper half block, a plain space if both quarters have the same color
+			strcpy(glyph->text[half], (glyph->fg[half] == glyph->bg[half]) ? " " : "\xe2\x96\x80");
+		}
+	}
+}
+
+// the terminal got resized (SIGWINCH), draw everything again
+static void terminal_resized(const int sig) {
+	(void)sig;
+#ifdef XORX_POSIX
+	state.terminal.resized = 1;
+#endif
+}
+
+// switch the terminal into raw mode, hide the cursor and build the glyph table
+static void open_terminal(void) {
+#ifdef XORX_POSIX
+	if (!tcgetattr(STDIN_FILENO, &state.terminal.saved)) {
+		// no echo, no line buffering and reads never block
+		struct termios raw = state.terminal.saved;
+		raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+		raw.c_iflag &= ~(IXON | ICRNL);
+		raw.c_cc[VMIN] = 0; raw.c_cc[VTIME] = 0;
+		if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw)) fail("tcsetattr() error: %s", strerror(errno));
+		state.terminal.raw = true;
+	}
+	signal(SIGWINCH, terminal_resized);
+#else
+	fail("The terminal renderer needs a POSIX system");
+#endif
+	build_glyphs();
+	fputs("\x1b[?25l", stdout);
+	state.video.stale = true;
+}
+
+// restore the terminal
+static void close_terminal(void) {
+	if (state.video.backend != BACKEND_TERMINAL) return;
+	printf("\x1b[0m\x1b[%dH\x1b[?25h\n", state.video.rows + HUD_ROWS);
+	fflush(stdout);
+#ifdef XORX_POSIX
+	if (state.terminal.raw) tcsetattr(STDIN_FILENO, TCSAFLUSH, &state.terminal.saved);
+	state.terminal.raw = false;
+#endif
+}
+
+// read the keys typed into the terminal, they count as held for a moment as terminals report no key releases
+static void read_terminal(void) {
+#ifdef XORX_POSIX
+	uint8_t keys[64];
+	const int count = (int)read(STDIN_FILENO, keys, sizeof(keys));
+	const uint64_t now = SDL_GetTicks();
+	for (int i = 0; i < count; ++i) {
+		SDL_Keycode key = keys[i];
+		if ((key == SDLK_ESCAPE) && (i + 2 < count) && (keys[i + 1] == '[')) {
+			// cursor keys are escape sequences
+			switch (keys[i + 2]) {
+				case 'A': key = SDLK_UP; break;
+				case 'B': key = SDLK_DOWN; break;
+				case 'C': key = SDLK_RIGHT; break;
+				case 'D': key = SDLK_LEFT; break;
+			}
+			i += 2;
+		}
+		else if ((key == 'q') || (key == 3)) key = SDLK_ESCAPE; // q / Ctrl-C
+		else if (key == 12) { state.video.stale = true; continue; } // Ctrl-L redraws the screen
+		else if (key == '\n') key = SDLK_RETURN;
+		if (now >= state.terminal.release) state.input.buttons = BUTTON_NONE;
+		handle_keyboard(key, true);
+		state.terminal.release = now + TERMINAL_HOLD;
+	}
+	if (now >= state.terminal.release) state.input.buttons = BUTTON_NONE;
+	if (state.terminal.resized) { state.terminal.resized = 0; state.video.stale = true; }
+#endif
+}
+
+// draw the changed tiles into the terminal, only escape sequences of the changed character cells get written
+static void draw_terminal(void) {
+	char out[TERMINAL_OUTPUT];
+	int length = 0, cx = -1, cy = -1;
+	if (state.video.stale) {
+		length += snprintf(out, sizeof(out), "\x1b[0m\x1b[2J");
+		state.terminal.fg = state.terminal.bg = -1;
+	}
+	compose_display();
+	for (int y = 0; y < state.video.rows + HUD_ROWS; ++y) {
+		for (int x = 0; x < state.video.cols; ++x) {
+			const uint8_t tile = state.video.shown[y][x];
+			if (!state.video.stale && (state.video.drawn[y][x] == tile)) continue;
+			state.video.drawn[y][x] = tile;
+			const glyph_t *glyph = &state.terminal.glyphs[tile];
+			if (length > TERMINAL_OUTPUT - 64) {
+				// large views get written in several pieces
+				fwrite(out, 1, length, stdout);
+				length = 0;
+			}
+			// the cursor only has to move if the last written tile isn't the left neighbour
+			if ((cy != y) || (cx != x)) length += snprintf(out + length, sizeof(out) - length, "\x1b[%d;%dH", y + 1, x * 2 + 1);
+			for (int half = 0; half < 2; ++half) {
+				const bool space = glyph->text[half][0] == ' ';
+				const int fg = glyph->fg[half], bg = glyph->bg[half];
+				if (bg != state.terminal.bg) length += snprintf(out + length, sizeof(out) - length, "\x1b[%dm", (bg < 8) ? 40 + bg : 100 + bg - 8);
+				if (!space && (fg != state.terminal.fg)) length += snprintf(out + length, sizeof(out) - length, "\x1b[%dm", (fg < 8) ? 30 + fg : 90 + fg - 8);
+				if (!space) state.terminal.fg = fg;
+				state.terminal.bg = bg;
+				length += snprintf(out + length, sizeof(out) - length, "%s", glyph->text[half]);
+			}
+			cx = x + 1; cy = y;
+		}
+	}
+	state.video.stale = false;
+	if (length) {
+		fwrite(out, 1, length, stdout);
+		fflush(stdout);
+	}
+}
+
+// update video rendering
+static void update_video(void) {
+	if (state.video.backend == BACKEND_TERMINAL) {
+		draw_terminal();
+		return;
+	}
+	if (state.video.backend == BACKEND_SURFACE) {
+		draw_surface();
+		return;
+	}
+	if (!SDL_RenderClear(state.video.renderer)) fail("SDL_RenderClear() error: %s", SDL_GetError());
+	switch (state.video.backend) {
+		case BACKEND_FRAMEBUFFER: draw_framebuffer(); break;
+		case BACKEND_INDEXED: draw_indexed(); break;
+		default: draw_tiles(); break;
+	}
+	if (!SDL_RenderPresent(state.video.renderer)) fail("SDL_RenderPresent() error: %s", SDL_GetError());
+}
+
+// names of the render backends (--renderer)
+static const char *backend_names[BACKEND_COUNT] = { "auto", "tiles", "framebuffer", "indexed", "surface", "terminal" };
+
+// pick the render backend and create what it needs
+static void init_backend(void) {
+	if (state.video.backend == BACKEND_AUTO) {
+		const char *name = SDL_GetRendererName(state.video.renderer);
+		state.video.backend = (name && !strcmp(name, SDL_SOFTWARE_RENDERER)) ? BACKEND_FRAMEBUFFER : BACKEND_TILES;
+	}
+	if (state.video.backend == BACKEND_TERMINAL) open_terminal();
+	if (state.video.backend == BACKEND_SURFACE) {
+		state.video.strip = SDL_CreateSurfaceFrom(TILE_WIDTH, 256 * TILE_HEIGHT, SDL_PIXELFORMAT_XRGB8888, state.tileset.pixels, TILE_WIDTH * sizeof(uint32_t));
+		if (!state.video.strip) fail("SDL_CreateSurfaceFrom() error: %s", SDL_GetError());
+		SDL_SetWindowSurfaceVSync(state.video.window, 1);
+		state.video.stale = true;
+	}
+	if (state.video.backend == BACKEND_TILES) {
+		for (int i = 0; i < LAYER_CACHE; ++i) state.video.cache[i].screen = invalid_position;
+		state.video.layers = true;
+		create_minimap();
+	}
+	if ((state.video.backend == BACKEND_INDEXED) && !state.tileset.colors) {
+		SDL_Log("Too many colors in the tileset for the indexed renderer, using the framebuffer");
+		state.video.backend = BACKEND_FRAMEBUFFER;
+	}
+	if ((state.video.backend == BACKEND_FRAMEBUFFER) || (state.video.backend == BACKEND_INDEXED)) {
+		// the framebuffer gets upscaled and letterboxed on its own
+		if (!SDL_SetRenderLogicalPresentation(state.video.renderer, 0, 0, SDL_LOGICAL_PRESENTATION_DISABLED)) fail("SDL_SetRenderLogicalPresentation() error: %s", SDL_GetError());
+		state.video.stale = true;
+	}
+}
+
+// create the tile atlas texture from the tileset pixels, the clear color is the first pixel of the tileset
+static SDL_Texture *load_tiles(void) {
+	const int width = 16 * TILE_WIDTH, height = 16 * TILE_HEIGHT;
+	uint32_t *atlas = SDL_malloc(width * height * sizeof(uint32_t));
+	if (!atlas) fail("Out of memory");
+	for (int tile = 0; tile < 256; ++tile) {
+		for (int y = 0; y < TILE_HEIGHT; ++y) memcpy(atlas + ((tile / 16) * TILE_HEIGHT + y) * width + (tile % 16) * TILE_WIDTH, state.tileset.pixels[tile][y], TILE_WIDTH * sizeof(uint32_t));
+	}
+	const uint32_t color = state.tileset.pixels[0][0][0];
+	SDL_SetRenderDrawColor(state.video.renderer, color >> 16, color >> 8, color, 255);
+	SDL_Texture *texture = SDL_CreateTexture(state.video.renderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+	const bool ok = texture && SDL_UpdateTexture(texture, NULL, atlas, width * sizeof(uint32_t));
+	SDL_free(atlas);
+	if (!ok) fail("SDL_CreateTexture() error: %s", SDL_GetError());
+	if (!SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST)) fail("SDL_SetTextureScaleMode() error: %s", SDL_GetError());
+	return texture;
+}
+
+// the renderer lost the contents of its render targets (a device reset loses every texture), draw everything again
+static void reset_textures(const bool device) {
+	for (int i = 0; i < LAYER_CACHE; ++i) {
+		layer_t *layer = &state.video.cache[i];
+		layer->screen = invalid_position;
+		if (device && layer->texture) { SDL_DestroyTexture(layer->texture); layer->texture = NULL; }
+	}
+	state.video.stale = true;
+	if (!device) return;
+	if (state.video.texture) { SDL_DestroyTexture(state.video.texture); state.video.texture = load_tiles(); }
+	if (state.minimap.texture) { SDL_DestroyTexture(state.minimap.texture); create_minimap(); }
+	state.video.scale = 0; // present_framebuffer() creates the frame texture again
+}
+
+// load sound effect, out of the pack the samples are played right from there
+static sound_t load_sound(const char *name) {
+	if (state.pack.data) {
+		// sounds which aren't in the pack don't exist
+		const pack_entry_t *asset = find_asset(name);
+		if (!asset || asset->width) return (sound_t){};
+		return (sound_t){ .samples = (const int16_t*)(state.pack.data + asset->offset), .length = asset->size / sizeof(int16_t) };
+	}
+	SDL_AudioSpec spec; Uint8 *data; Uint32 length;
+	if (!SDL_LoadWAV(name, &spec, &data, &length)) return (sound_t){};
+	if ((spec.format != SDL_AUDIO_S16) || (spec.freq != AUDIO_RATE) || (spec.channels != 1)) {
+		SDL_free(data);
+		fail("Sound(%s) has wrong format", name);
+	}
+	return (sound_t){ .samples = (int16_t*)data, .length = length / sizeof(int16_t) };
+}
+
+// check if the memory belongs to the asset pack
+static bool in_pack(const void *p) {
+	return state.pack.data && ((const uint8_t*)p >= state.pack.data) && ((const uint8_t*)p < state.pack.data + state.pack.size);
+}
+
+// check the header and the directory of the pack
+static bool check_pack(const uint8_t *data, const size_t size) {
+	const pack_header_t *header = (const pack_header_t*)data;
+	if ((size < sizeof(pack_header_t)) || (header->magic != PACK_MAGIC) || (header->version != PACK_VERSION) || (header->size != size) || (header->count > PACK_ASSETS)) return false;
+	if (size < sizeof(pack_header_t) + header->count * sizeof(pack_entry_t)) return false;
+	const pack_entry_t *entries = (const pack_entry_t*)(header + 1);
+	for (uint32_t i = 0; i < header->count; ++i) {
+		const pack_entry_t *asset = &entries[i];
+		if (!memchr(asset->name, 0, sizeof(asset->name)) || (asset->offset % PACK_ALIGN) || (asset->offset > size) || (asset->size > size - asset->offset)) return false;
+		if (asset->width && ((uint64_t)asset->width * asset->height * sizeof(uint32_t) != asset->size)) return false;
+	}
+	return true;
+}
+
+// open the asset pack, it gets mapped into memory and all assets are used right from there
+static void open_pack(const char *path) {
+#ifdef XORX_POSIX
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) fail("Can't open pack %s: %s", path, strerror(errno));
+	const off_t size = lseek(fd, 0, SEEK_END);
+	void *data = (size > 0) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (data == MAP_FAILED) fail("Can't map pack %s: %s", path, strerror(errno));
+	// read the whole pack ahead in one go, everything in it is needed at startup
+	madvise(data, size, MADV_WILLNEED);
+	state.pack.mapped = true;
+#else
+	size_t size;
+	void *data = SDL_LoadFile(path, &size);
+	if (!data) fail("Can't open pack %s: %s", path, SDL_GetError());
+	state.pack.loaded = true;
+#endif
+	state.pack.data = data;
+	state.pack.size = size;
+	if (!check_pack(state.pack.data, state.pack.size)) fail("Pack %s is broken or was made for another version", path);
+}
+
+// release the asset pack (nothing may point into it anymore)
+static void close_pack(void) {
+#ifdef XORX_POSIX
+	if (state.pack.mapped) munmap((void*)state.pack.data, state.pack.size);
+#endif
+	if (state.pack.loaded) SDL_free((void*)state.pack.data);
+	state.pack.data = NULL;
+	state.pack.mapped = state.pack.loaded = false;
+}
+
+// read the colors of a world image, returns false if it has the wrong size
+static bool world_colors(SDL_Surface *surface, uint32_t colors[MAP_ROWS][MAP_COLS]) {
+	if (!surface) return false;
+	SDL_Surface *pixels = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_XRGB8888);
+	SDL_DestroySurface(surface);
+	if (!pixels) return false;
+	const bool ok = (pixels->w == MAP_COLS) && (pixels->h == MAP_ROWS);
+	for (int y = 0; ok && (y < MAP_ROWS); ++y) {
+		const uint32_t *row = (const uint32_t*)((const uint8_t*)pixels->pixels + y * pixels->pitch);
+		for (int x = 0; x < MAP_COLS; ++x) colors[y][x] = row[x] & 0xffffff;
+	}
+	SDL_DestroySurface(pixels);
+	if (!ok) SDL_SetError("wrong size");
+	return ok;
+}
+
+// turn walls into solid walls (wall x) if they are enclosed by walls and back if they aren't anymore
+static bool enclose(xorx_t *ctx, const vec_t v) {
+	if (!iswall(ctx, v)) return false;
+	const bool solid = get(ctx, v).tile == TILE_WALL_X;
+	if (enclosed(ctx, v) == solid) return false;
+	shape(ctx, v, solid ? TILE_WALL_0 + rnd(ctx) % 4 : TILE_WALL_X, 0);
+	return true;
+}
+
+// apply the changes of world.bmp to the pristine and the running world, only the changed cells and their neighbours are touched
+static void reload_world(void) {
+	static uint32_t colors[MAP_ROWS][MAP_COLS];
+	static vec_t changed[MAP_ROWS * MAP_COLS];
+	SDL_Surface *surface = SDL_LoadBMP("world.bmp");
+	if (!surface || !world_colors(surface, colors)) {
+		SDL_Log("Can't reload world.bmp: %s", SDL_GetError());
+		return;
+	}
+	xorx_t *world = SDL_calloc(1, sizeof(xorx_t)), *ctx = &state.xorx;
+	if (!world) fail("Out of memory");
+	world->game = state.world.game;
+	int count = 0;
+	for (int y = 0; y < MAP_ROWS; ++y) {
+		if (!memcmp(colors[y], state.reload.world[y], sizeof(colors[y]))) continue;
+		for (int x = 0; x < MAP_COLS; ++x) {
+			const uint32_t color = colors[y][x];
+			if (color == state.reload.world[y][x]) continue;
+			const vec_t v = vec2(x, y);
+			// a moved player start would leave the running game with a second player
+			if ((color == 0xffffff) || (state.reload.world[y][x] == 0xffffff)) {
+				if (!state.reload.warned) SDL_Log("world.bmp: moving the player start needs a restart");
+				state.reload.warned = true;
+				continue;
+			}
+			state.reload.world[y][x] = color;
+			spawn(world, v, color);
+			bool player = false;
+			for (int i = 0; i < ctx->players; ++i) player |= veq(ctx->game.player[i], v);
+			if (!player) {
+				spawn(ctx, v, color);
+				// cells off the active screen keep their ticks relative to when it was left
+				if (!veq(vbase(v), ctx->game.view)) hibernate(ctx, v);
+			}
+			changed[count++] = v;
+		}
+	}
+	for (int i = 0; i < count; ++i) {
+		for (int y = -1; y <= 1; ++y) {
+			for (int x = -1; x <= 1; ++x) {
+				const vec_t v = vadd(changed[i], vec2(x, y));
+				if (!inside(v)) continue;
+				enclose(world, v);
+				if (enclose(ctx, v) && !veq(vbase(v), ctx->game.view)) hibernate(ctx, v);
+			}
+		}
+	}
+	// restarts and new replays start from the random numbers of the loaded world
+	world->game.rand = state.world.game.rand;
+	state.world.game = world->game;
+	SDL_free(world);
+	SDL_Log("world.bmp reloaded, %d cells changed", count);
+}
+
+// apply the changes of tiles.bmp, only the changed tiles get uploaded into the atlas texture
+static void reload_tiles(void) {
+	SDL_Surface *surface = SDL_LoadBMP("tiles.bmp");
+	SDL_Surface *pixels = surface ? SDL_ConvertSurface(surface, SDL_PIXELFORMAT_XRGB8888) : NULL;
+	if (surface) SDL_DestroySurface(surface);
+	if (!pixels || (pixels->w != 16 * TILE_WIDTH) || (pixels->h != 16 * TILE_HEIGHT)) {
+		SDL_Log("Can't reload tiles.bmp: %s", pixels ? "wrong size" : SDL_GetError());
+		if (pixels) SDL_DestroySurface(pixels);
+		return;
+	}
+	// the capture thread may compose a screenshot from the tileset right now
+	int count = 0;
+	uint8_t changed[256];
+	if (state.capture.mutex) SDL_LockMutex(state.capture.mutex);
+	for (int tile = 0; tile < 256; ++tile) {
+		uint32_t next[TILE_HEIGHT][TILE_WIDTH];
+		for (int y = 0; y < TILE_HEIGHT; ++y) {
+			const uint8_t *row = (const uint8_t*)pixels->pixels + ((tile / 16) * TILE_HEIGHT + y) * pixels->pitch;
+			memcpy(next[y], row + (tile % 16) * TILE_WIDTH * sizeof(uint32_t), sizeof(next[y]));
+		}
+		if (!memcmp(next, state.tileset.pixels[tile], sizeof(next))) continue;
+		memcpy(state.tileset.pixels[tile], next, sizeof(next));
+		changed[count++] = tile;
+	}
+	if (state.capture.mutex) SDL_UnlockMutex(state.capture.mutex);
+	SDL_DestroySurface(pixels);
+	for (int i = 0; (i < count) && state.video.texture; ++i) {
+		const int tile = changed[i];
+		// room for a tile in any pixel format of the texture
+		uint32_t converted[TILE_HEIGHT][TILE_WIDTH * 4];
+		const SDL_Rect rect = { .x = (tile % 16) * TILE_WIDTH, .y = (tile / 16) * TILE_HEIGHT, .w = TILE_WIDTH, .h = TILE_HEIGHT };
+		if (!SDL_ConvertPixels(TILE_WIDTH, TILE_HEIGHT, SDL_PIXELFORMAT_XRGB8888, state.tileset.pixels[tile], TILE_WIDTH * sizeof(uint32_t), state.video.texture->format, converted, sizeof(converted[0])) ||
+			!SDL_UpdateTexture(state.video.texture, &rect, converted, sizeof(converted[0]))) fail("SDL_UpdateTexture() error: %s", SDL_GetError());
+	}
+	SDL_Log("tiles.bmp reloaded, %d tiles changed", count);
+	if (!count) return;
+	// everything derived from the tileset follows
+	index_tileset();
+	color_minimap();
+	if (state.video.backend == BACKEND_TERMINAL) build_glyphs();
+	if ((state.video.backend == BACKEND_INDEXED) && !state.tileset.colors) {
+		SDL_Log("Too many colors in the tileset for the indexed renderer, using the framebuffer");
+		state.video.backend = BACKEND_FRAMEBUFFER;
+	}
+	const uint32_t color = state.tileset.pixels[0][0][0];
+	if (state.video.renderer) SDL_SetRenderDrawColor(state.video.renderer, color >> 16, color >> 8, color, 255);
+	memset(state.xorx.video.changed, 0xff, sizeof(state.xorx.video.changed));
+	state.video.size = vec2(0, 0);
+	state.video.stale = true;
+}
+
+// watch the assets in the current directory for changes (editors often write a new file and rename it)
+static void open_reload(void) {
+#ifdef XORX_INOTIFY
+	if ((state.replay.path) || (state.xorx.players > 1) || (state.spectate.viewer >= 0)) fail("Reloading the assets only works in single player games without recording");
+	if (!world_colors(load_image("world.bmp"), state.reload.world)) fail("Can't read world.bmp: %s", SDL_GetError());
+	if ((state.reload.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0) fail("inotify_init1() error: %s", strerror(errno));
+	if (inotify_add_watch(state.reload.fd, ".", IN_CLOSE_WRITE | IN_MOVED_TO) < 0) fail("inotify_add_watch() error: %s", strerror(errno));
+#else
+	fail("Reloading the assets is not supported on this platform");
+#endif
+}
+
+// reload the assets which were written since the last frame
+static void update_reload(void) {
+#ifdef XORX_INOTIFY
+	_Alignas(struct inotify_event) char buffer[4096];
+	bool world = false, tiles = false;
+	for (ssize_t length; (length = read(state.reload.fd, buffer, sizeof(buffer))) > 0;) {
+		for (char *p = buffer; p < buffer + length; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+			const struct inotify_event *event = (const struct inotify_event*)p;
+			if (event->len && !strcmp(event->name, "world.bmp")) world = true;
+			if (event->len && !strcmp(event->name, "tiles.bmp")) tiles = true;
+		}
+	}
+	if (world) reload_world();
+	if (tiles) reload_tiles();
+#endif
+}
+
+// stop watching the assets
+static void close_reload(void) {
+#ifdef XORX_INOTIFY
+	if (state.reload.fd >= 0) close(state.reload.fd);
+	state.reload.fd = -1;
+#endif
+}
+
+// note a finished startup phase begun at the performance counter begin, returns the end of it
+static uint64_t phase(const char *name, const uint64_t begin) {
+	const uint64_t end = SDL_GetPerformanceCounter();
+	const int i = SDL_AddAtomicInt(&state.startup.count, 1);
+	if (i < STARTUP_PHASES) state.startup.phases[i] = (phase_t){ .name = name, .loader = loader_error != NULL, .begin = begin, .end = end };
+	return end;
+}
+
+// initialize the gamepads once the first frame is shown, enumerating the devices may take a while on some systems
+// the gamepads already plugged in show up as SDL_EVENT_GAMEPAD_ADDED like every other one
+// SDL wants this on the main thread, so the game pauses meanwhile instead of catching up the missed ticks afterwards
+static void init_gamepads(void) {
+	const uint64_t t = SDL_GetPerformanceCounter();
+	if (!SDL_InitSubSystem(SDL_INIT_GAMEPAD)) SDL_Log("SDL_InitSubSystem() error: %s, no gamepads", SDL_GetError());
+	state.time.last = SDL_GetTicks();
+	phase("gamepads", t);
+}
+
+// log the startup phases (--timing), called when the first frame was shown
+static void report_startup(void) {
+	const double ms = 1000.0 / SDL_GetPerformanceFrequency();
+	const int count = mini(SDL_GetAtomicInt(&state.startup.count), STARTUP_PHASES);
+	for (int i = 0; i < count; ++i) {
+		const phase_t *p = &state.startup.phases[i];
+		SDL_Log("%-6s %-16s %8.2f ms  (%8.2f - %8.2f ms)", p->loader ? "loader" : "main", p->name, (p->end - p->begin) * ms, (p->begin - state.startup.start) * ms, (p->end - state.startup.start) * ms);
+	}
+	SDL_Log("first frame after %.2f ms", (state.startup.shown - state.startup.start) * ms);
+}
+
+// load the tileset, the sounds and the world while the main thread creates the window, the renderer and the audio device
+static int load_assets(void *data) {
+	(void)data;
+	jmp_buf error;
+	int loaded = 0;
+	if (!setjmp(error)) {
+		loader_error = &error;
+		uint64_t t = SDL_GetPerformanceCounter();
+		load_tileset("tiles.bmp"); // screenshots (and the surface backend) stay black without it
+		t = phase("tileset", t);
+		for (int i = 0; i < AUDIO_SOUNDS; ++i) state.audio.sounds[i] = load_sound(strf("sound%02d.wav", i));
+		t = phase("sounds", t);
+		load_world("world.bmp");
+		phase("world", t);
+		loaded = 1;
+	}
+	loader_error = NULL; // this may be the main thread, when no thread could be created
+	return loaded;
+}
+
+// convert tiles.bmp, world.bmp and the sounds into the native formats of the engine and write them into a single pack
+static bool make_pack(const char *path) {
+	const SDL_AudioSpec want = { .format = SDL_AUDIO_S16, .freq = AUDIO_RATE, .channels = 1 };
+	static const char *images[] = { "tiles.bmp", "world.bmp" };
+	pack_entry_t entries[PACK_ASSETS] = {0};
+	uint8_t *data[PACK_ASSETS] = {0};
+	int count = 0;
+	for (int i = 0; i < 2; ++i) {
+		SDL_Surface *surface = SDL_LoadBMP(images[i]);
+		SDL_Surface *pixels = surface ? SDL_ConvertSurface(surface, SDL_PIXELFORMAT_XRGB8888) : NULL;
+		if (surface) SDL_DestroySurface(surface);
+		if (!pixels) fail("Can't load %s: %s", images[i], SDL_GetError());
+		const size_t pitch = pixels->w * sizeof(uint32_t);
+		if (!(data[count] = SDL_malloc(pitch * pixels->h))) fail("Out of memory");
+		for (int y = 0; y < pixels->h; ++y) memcpy(data[count] + y * pitch, (const uint8_t*)pixels->pixels + y * pixels->pitch, pitch);
+		entries[count] = (pack_entry_t){ .size = pitch * pixels->h, .width = pixels->w, .height = pixels->h };
+		SDL_strlcpy(entries[count++].name, images[i], sizeof(entries[0].name));
+		SDL_DestroySurface(pixels);
+	}
+	for (int i = 0; i < AUDIO_SOUNDS; ++i) {
+		const char *name = strf("sound%02d.wav", i);
+		SDL_AudioSpec spec; Uint8 *wav; Uint32 length; int size;
+		if (!SDL_LoadWAV(name, &spec, &wav, &length)) continue;
+		const bool ok = SDL_ConvertAudioSamples(&spec, wav, (int)length, &want, &data[count], &size);
+		SDL_free(wav);
+		if (!ok) fail("Can't convert %s: %s", name, SDL_GetError());
+		entries[count] = (pack_entry_t){ .size = size };
+		SDL_strlcpy(entries[count++].name, name, sizeof(entries[0].name));
+	}
+	// the directory follows the header, every asset starts aligned after it
+	uint32_t offset = sizeof(pack_header_t) + count * sizeof(pack_entry_t);
+	for (int i = 0; i < count; ++i) {
+		entries[i].offset = offset = (offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+		offset += entries[i].size;
+	}
+	const pack_header_t header = { .magic = PACK_MAGIC, .version = PACK_VERSION, .count = count, .size = offset };
+	uint8_t *pack = SDL_calloc(1, offset);
+	if (!pack) fail("Out of memory");
+	memcpy(pack, &header, sizeof(header));
+	memcpy(pack + sizeof(header), entries, count * sizeof(pack_entry_t));
+	for (int i = 0; i < count; ++i) {
+		memcpy(pack + entries[i].offset, data[i], entries[i].size);
+		SDL_free(data[i]);
+	}
+	// a path ending with .h gets the pack as C array initializer to compile it into the game (make embed)
+	const size_t length = strlen(path);
+	bool ok;
+	if ((length >= 2) && !strcmp(path + length - 2, ".h")) {
+		static const char hex[] = "0123456789abcdef";
+		char *text = SDL_malloc((size_t)offset * 5 + offset / 16 + 1), *out = text;
+		if (!text) fail("Out of memory");
+		for (uint32_t i = 0; i < offset; ++i) {
+			*out++ = '0'; *out++ = 'x'; *out++ = hex[pack[i] >> 4]; *out++ = hex[pack[i] & 15]; *out++ = ',';
+			if ((i % 16 == 15) || (i == offset - 1)) *out++ = '\n';
+		}
+		ok = SDL_SaveFile(path, text, out - text);
+		SDL_free(text);
+	} else {
+		ok = SDL_SaveFile(path, pack, offset);
+	}
+	SDL_free(pack);
+	if (!ok) SDL_Log("%s: %s", path, SDL_GetError());
+	else SDL_Log("OK: %d assets (%u bytes) packed into %s", count, offset, path);
+	return ok;
+}
+
+// callback to initialize the application
+SDL_AppResult SDL_AppInit(void **appstate, int argc, char **argv) {
+	(void)appstate;
+	// init core system
+	state = (struct state_t){
+		.core.running = true,
+		.bot = { .rand = 0x2545f491, .explore = true, .last = { -1, -1 } },
+		.spectate.server = -1, .spectate.viewer = -1,
+		.coop.server = -1, .coop.rollback = UINT64_MAX,
+		.reload.fd = -1,
+		.video.cols = VIEW_COLS, .video.rows = VIEW_ROWS,
+		.xorx.players = 1,
+		.startup.start = SDL_GetPerformanceCounter(),
+	};
+	if (setjmp(state.core.error)) return SDL_APP_FAILURE;
+
+	// parse command line
+	char **verify = NULL, **render = NULL; int verifies = 0, seeds = 0; uint64_t ticks = 0;
+	const char *map = NULL, *from = NULL, *packing = NULL;
+	for (int i = 1; (i < argc) && !verify; ++i) {
+		if (!strcmp(argv[i], "--shm") && (i + 1 < argc)) open_shm(argv[++i]);
+		else if (!strcmp(argv[i], "--broadcast") && (i + 1 < argc)) state.spectate.server = open_socket(state.spectate.path = argv[++i], true);
+		else if (!strcmp(argv[i], "--watch") && (i + 1 < argc)) state.spectate.viewer = open_socket(argv[++i], false);
+		else if (!strcmp(argv[i], "--host") && (i + 1 < argc)) host_coop(argv[++i]);
+		else if (!strcmp(argv[i], "--join") && (i + 1 < argc)) join_coop(argv[++i]);
+		else if (!strcmp(argv[i], "--record") && (i + 1 < argc)) state.replay.path = argv[++i];
+		else if (!strcmp(argv[i], "--verify") && (i + 1 < argc)) { verify = argv + i + 1; verifies = argc - i - 1; }
+		else if (!strcmp(argv[i], "--render") && (i + 2 < argc)) { render = argv + i + 1; i += 2; }
+		else if (!strcmp(argv[i], "--export-map") && (i + 1 < argc)) {
+			map = argv[++i];
+			if ((i + 1 < argc) && (argv[i + 1][0] != '-')) from = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--soak") && (i + 2 < argc)) { seeds = atoi(argv[i + 1]); ticks = strtoull(argv[i + 2], NULL, 10); i += 2; }
+		else if (!strcmp(argv[i], "--bot")) state.input.bot = true;
+		else if (!strcmp(argv[i], "--pack") && (i + 1 < argc)) open_pack(argv[++i]);
+		else if (!strcmp(argv[i], "--make-pack") && (i + 1 < argc)) packing = argv[++i];
+		else if (!strcmp(argv[i], "--timing")) state.startup.timing = true;
+		else if (!strcmp(argv[i], "--reload")) state.reload.enabled = true;
+		else if (!strcmp(argv[i], "--view") && (i + 1 < argc)) {
+			const char *view = argv[++i];
+			if ((sscanf(view, "%dx%d", &state.video.cols, &state.video.rows) != 2) || (state.video.cols < VIEW_COLS) || (state.video.cols > DISPLAY_COLS) ||
+				(state.video.rows < VIEW_ROWS) || (state.video.rows > DISPLAY_ROWS - HUD_ROWS)) fail("Invalid view: %s (%dx%d up to %dx%d)", view, VIEW_COLS, VIEW_ROWS, DISPLAY_COLS, DISPLAY_ROWS - HUD_ROWS);
+		}
+		else if (!strcmp(argv[i], "--renderer") && (i + 1 < argc)) {
+			const char *name = argv[++i];
+			for (state.video.backend = 0; (state.video.backend < BACKEND_COUNT) && strcmp(name, backend_names[state.video.backend]); ++state.video.backend);
+			if (state.video.backend == BACKEND_COUNT) fail("Unknown renderer: %s", name);
+		}
+		else fail("Unknown command line option: %s", argv[i]);
+	}
+
+	// convert the assets into a pack without any window or audio
+	if (packing) return make_pack(packing) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+#ifdef XORX_EMBED
+	// the compiled in pack, unless another one was given
+	if (!state.pack.data) {
+		state.pack.data = embedded_pack;
+		state.pack.size = sizeof(embedded_pack);
+		if (!check_pack(state.pack.data, state.pack.size)) fail("The compiled in pack is broken");
+	}
+#endif
+
+	// verify / render replays, export the map or soak test without any window or audio
+	if (verify || render || map || seeds) {
+		if (!load_world("world.bmp")) fail("Can't load world.bmp: %s", SDL_GetError());
+		if (verify) return verify_replays(verify, verifies) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+		if (render || map) {
+			if (!load_tileset("tiles.bmp")) fail("Can't load tiles.bmp: %s", SDL_GetError());
+			if (map) return export_map(map, from) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+			return render_replay(render[0], render[1]) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+		}
+		if ((seeds < 1) || (ticks < 1)) fail("Invalid soak test: %d seeds, %llu ticks", seeds, (unsigned long long)ticks);
+		return soak_test(seeds, ticks) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+	}
+	// the assets get loaded on a thread meanwhile (right here if there is no thread)
+	uint64_t t = phase("command line", state.startup.start);
+	if (!(state.startup.loader = SDL_CreateThread(load_assets, "loader", NULL))) load_assets(NULL);
+
+	// the terminal renderer needs neither a window nor audio
+	const bool terminal = state.video.backend == BACKEND_TERMINAL;
+	if (!SDL_Init(terminal ? SDL_INIT_EVENTS : (SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_EVENTS))) fail("SDL_Init() error: %s", SDL_GetError());
+	t = phase("SDL_Init", t);
+	if (terminal) {
+		// there is no vsync to wait for, don't spin through the frames
+		SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, strf("%d", TICK_RATE * 2));
+	} else {
+		// init video system
+		const int width = state.video.cols * TILE_WIDTH, height = (state.video.rows + HUD_ROWS) * TILE_HEIGHT;
+		int w = width, h = height;
+		const SDL_DisplayMode *dm = SDL_GetDesktopDisplayMode(1);
+		if (dm) {
+			const int factor = maxi(1, mini((dm->w * WINDOW_SCALE) / width, (dm->h * WINDOW_SCALE) / height));
+			w *= factor; h *= factor;
+		}
+		if (!(state.video.window = SDL_CreateWindow(WINDOW_TITLE, w, h, SDL_WINDOW_RESIZABLE))) fail("SDL_CreateWindow() error: %s", SDL_GetError());
+		t = phase("window", t);
+		if (state.video.backend != BACKEND_SURFACE) {
+			if (!(state.video.renderer = SDL_CreateRenderer(state.video.window, NULL))) fail("SDL_CreateRenderer() error: %s", SDL_GetError());
+			if (!SDL_SetRenderVSync(state.video.renderer, 1)) fail("SDL_SetRenderVSync() error: %s", SDL_GetError());
+			if (!SDL_SetRenderLogicalPresentation(state.video.renderer, width, height, SDL_LOGICAL_PRESENTATION_LETTERBOX)) fail("SDL_SetRenderLogicalPresentation() error: %s", SDL_GetError());
+			t = phase("renderer", t);
+		}
+
+		// init audio system
+		const SDL_AudioSpec want = { .format = SDL_AUDIO_S16, .freq = AUDIO_RATE, .channels = 1 };
+		if (!(state.audio.device = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL))) fail("SDL_OpenAudioDevice() error: %s", SDL_GetError());
+		if (!(state.audio.stream = SDL_CreateAudioStream(&want, NULL))) fail("SDL_CreateAudioStream() error: %s", SDL_GetError());
+		if (!SDL_BindAudioStream(state.audio.device, state.audio.stream)) fail("SDL_BindAudioStream() error: %s", SDL_GetError());
+		t = phase("audio", t);
+	}
+
+	// init assets, the tile texture and the backend need the tileset from the loader
+	if (state.startup.loader) SDL_WaitThread(state.startup.loader, NULL);
+	state.startup.loader = NULL;
+	if (state.startup.error[0]) fail("%s", state.startup.error);
+	t = phase("waiting", t);
+	if (state.video.renderer) {
+		state.video.texture = load_tiles();
+		t = phase("tile texture", t);
+	}
+	init_backend();
+	t = phase("backend", t);
+
+	// init game + time system
+	on_init(&state.xorx);
+	state.xorx.journal.enabled = state.xorx.players > 1;
+	if (state.replay.path) open_replay(state.replay.path);
+	if (state.reload.enabled) open_reload();
+	state.time.last = SDL_GetTicks();
+	phase("game", t);
+
+	return SDL_APP_CONTINUE;
+}
+
+// callback to finalize the application
+void SDL_AppQuit(void *appstate, SDL_AppResult result) {
+	(void)appstate; (void)result;
+	// a failed startup may leave the loader running
+	if (state.startup.loader) SDL_WaitThread(state.startup.loader, NULL);
+
+	// shutdown audio system
+	for (int i = 0; i < AUDIO_SOUNDS; ++i) if (state.audio.sounds[i].samples && !in_pack(state.audio.sounds[i].samples)) SDL_free((void*)state.audio.sounds[i].samples);
+	if (state.audio.stream) SDL_DestroyAudioStream(state.audio.stream);
+	if (state.audio.device) SDL_CloseAudioDevice(state.audio.device);
+
+	// shutdown shared memory export + spectating + co-op
+	close_shm();
+	close_spectate();
+	close_replay();
+	close_coop();
+	stop_capture();
+	stop_pool();
+	close_terminal();
+	close_reload();
+
+	// shutdown video system
+	for (int i = 0; i < LAYER_CACHE; ++i) if (state.video.cache[i].texture) SDL_DestroyTexture(state.video.cache[i].texture);
+	if (state.video.frame) SDL_DestroyTexture(state.video.frame);
+	if (state.minimap.texture) SDL_DestroyTexture(state.minimap.texture);
+	SDL_free(state.video.upscaled);
+	if (state.video.strip) SDL_DestroySurface(state.video.strip);
 	if (state.video.texture) SDL_DestroyTexture(state.video.texture);
 	if (state.video.renderer) SDL_DestroyRenderer(state.video.renderer);
 	if (state.video.window) SDL_DestroyWindow(state.video.window);
+	close_pack();
 
 	// shutdown core system
 	SDL_Quit();
@@ -1082,6 +4187,15 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 		case SDL_EVENT_GAMEPAD_BUTTON_UP:
 			handle_gamepad(event->gbutton.button, false);
 			break;
+		case SDL_EVENT_WINDOW_EXPOSED:
+			state.video.stale = true;
+			break;
+		case SDL_EVENT_RENDER_TARGETS_RESET:
+			reset_textures(false);
+			break;
+		case SDL_EVENT_RENDER_DEVICE_RESET:
+			reset_textures(true);
+			break;
 		case SDL_EVENT_GAMEPAD_ADDED:
 			SDL_OpenGamepad(event->gdevice.which);
 			break;
@@ -1094,8 +4208,17 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
 	(void)appstate;
 	if (!state.core.running) return SDL_APP_SUCCESS;
 	if (setjmp(state.core.error)) return SDL_APP_FAILURE;
-	update_ticks();
+	if (state.video.backend == BACKEND_TERMINAL) read_terminal();
+	if (state.reload.fd >= 0) update_reload();
+	if (state.spectate.viewer >= 0) spectate(&state.xorx); else update_ticks();
 	update_audio();
 	update_video();
+	if (!state.startup.shown) {
+		state.startup.shown = SDL_GetPerformanceCounter();
+		if (state.video.backend != BACKEND_TERMINAL) init_gamepads();
+		if (state.startup.timing) report_startup();
+	}
 	return SDL_APP_CONTINUE;
 }
+
+#endif
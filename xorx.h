@@ -0,0 +1,90 @@
+/*
+========================================================================================================================
+
+	Kingdom of Xorx - library interface
+	Build with "make lib" and link against libxorx.a (and SDL3) to run game instances without a window.
+
+	Every instance is independent, so N threads can step N instances in parallel. Only xorx_init() touches
+	shared data and has to be called once before any instance is created.
+
+========================================================================================================================
+*/
+#ifndef XORX_H
+#define XORX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// screen dimensions of an instance
+enum {
+	XORX_VIDEO_COLS = 32, // video width in tiles
+	XORX_VIDEO_ROWS = 18, // video height in tiles
+	XORX_VIEW_COLS = 32, // visible world width in tiles
+	XORX_VIEW_ROWS = 16, // visible world height in tiles
+};
+
+// button bit-masks for xorx_step()
+enum {
+	XORX_BUTTON_A = 1, XORX_BUTTON_B = 2, XORX_BUTTON_X = 4, XORX_BUTTON_Y = 8,
+	XORX_BUTTON_UP = 16, XORX_BUTTON_DOWN = 32, XORX_BUTTON_LEFT = 64, XORX_BUTTON_RIGHT = 128,
+};
+
+// observations written by xorx_step_batch()
+enum {
+	XORX_OBSERVE_NONE, // no observation
+	XORX_OBSERVE_VIDEO, // whole screen (XORX_VIDEO_ROWS * XORX_VIDEO_COLS tiles per instance)
+	XORX_OBSERVE_VIEW, // visible world cells (XORX_VIEW_ROWS * XORX_VIEW_COLS tiles per instance)
+};
+
+// a single game instance
+typedef struct xorx_t xorx_t;
+
+// reward signals of a single instance for one tick
+typedef struct xorx_reward_t {
+	int life; // change of hitpoints
+	int ammo; // change of ammunition
+	bool screen; // player entered another screen
+	bool dead; // player is dead
+} xorx_reward_t;
+
+// load the world (NULL for "world.bmp") shared by all instances, returns false on error
+bool xorx_init(const char *world);
+
+// create a new instance running a fresh game, returns NULL if out of memory
+xorx_t *xorx_create(void);
+
+// destroy an instance
+void xorx_destroy(xorx_t *ctx);
+
+// stop the worker threads started by xorx_step_batch()
+void xorx_quit(void);
+
+// start a completely new game on the instance
+void xorx_reset(xorx_t *ctx);
+
+// advance the instance by a single tick with the given buttons held down
+void xorx_step(xorx_t *ctx, uint8_t buttons);
+
+// advance count instances by a single tick in parallel, buttons[i] is held down on ctx[i]
+// rewards (count entries) and observations (count contiguous observe-sized blocks) may be NULL
+// must not be called from several threads at once
+void xorx_step_batch(xorx_t **ctx, const uint8_t *buttons, int count, xorx_reward_t *rewards, int observe, uint8_t *observations);
+
+// return the number of ticks the instance has run
+uint64_t xorx_tick(const xorx_t *ctx);
+
+// return the screen content (XORX_VIDEO_ROWS * XORX_VIDEO_COLS tile indices, row by row)
+const uint8_t *xorx_video(const xorx_t *ctx);
+
+// return the bit-mask of sound effects triggered by the last xorx_step()
+uint32_t xorx_sounds(const xorx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+/*
+========================================================================================================================
+
+	Kingdom of Xorx - shared memory observation reader
+	Start the game with "xorx --shm /name" and it publishes every tick into the POSIX shared memory object "/name".
+	External tools (bots, analytics, overlays) include this header and read the newest frame without ever blocking
+	the game: every slot of the ring is guarded by a sequence lock, the reader just retries if it raced the writer.
+
+	Requires C11 atomics and a POSIX system (link with -lrt on older glibc).
+
+========================================================================================================================
+*/
+#ifndef XORX_SHM_H
+#define XORX_SHM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// layout of the shared memory object
+enum {
+	XORX_SHM_MAGIC = 0x58524f58, // "XORX"
+	XORX_SHM_VERSION = 1, // bumped on every layout change
+	XORX_SHM_SLOTS = 4, // number of frames in the ring
+	XORX_SHM_COLS = 32, // visible world width in tiles
+	XORX_SHM_ROWS = 16, // visible world height in tiles
+};
+
+// state of the game published for a single tick
+typedef struct xorx_frame_t {
+	uint64_t tick; // engine tick of this frame
+	int32_t life; // current hitpoints
+	int32_t ammo; // current ammunition
+	int32_t flasks; // current amount of flasks
+	uint8_t tiles[XORX_SHM_ROWS][XORX_SHM_COLS]; // visible cells (tile index into tiles.bmp)
+} xorx_frame_t;
+
+// a single ring slot, seq is odd while the game writes the frame
+typedef struct xorx_slot_t {
+	_Atomic uint32_t seq; // sequence lock
+	xorx_frame_t frame; // published frame
+} xorx_slot_t;
+
+// the whole shared memory object
+typedef struct xorx_shm_t {
+	uint32_t magic; // XORX_SHM_MAGIC
+	uint32_t version; // XORX_SHM_VERSION
+	_Atomic uint64_t head; // number of the newest slot (0 = nothing published yet)
+	xorx_slot_t slots[XORX_SHM_SLOTS]; // ring of frames
+} xorx_shm_t;
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// map the shared memory object published by the game read-only, returns NULL on error
+static inline xorx_shm_t *xorx_shm_open(const char *name) {
+	const int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) return NULL;
+	struct stat st;
+	if (fstat(fd, &st) || (st.st_size < (off_t)sizeof(xorx_shm_t))) { close(fd); return NULL; }
+	void *shm = mmap(NULL, sizeof(xorx_shm_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) return NULL;
+	if ((((xorx_shm_t*)shm)->magic != XORX_SHM_MAGIC) || (((xorx_shm_t*)shm)->version != XORX_SHM_VERSION)) {
+		munmap(shm, sizeof(xorx_shm_t));
+		return NULL;
+	}
+	return shm;
+}
+
+// unmap the shared memory object
+static inline void xorx_shm_close(xorx_shm_t *shm) {
+	if (shm) munmap(shm, sizeof(xorx_shm_t));
+}
+#endif
+
+// copy the newest frame, returns false if nothing was published yet
+static inline bool xorx_shm_read(xorx_shm_t *shm, xorx_frame_t *frame) {
+	for (;;) {
+		const uint64_t head = atomic_load_explicit(&shm->head, memory_order_acquire);
+		if (!head) return false;
+		xorx_slot_t *slot = &shm->slots[head % XORX_SHM_SLOTS];
+		const uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		if (seq & 1) continue;
+		memcpy(frame, &slot->frame, sizeof(*frame));
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq) return true;
+	}
+}
+
+#endif